@@ -1,52 +1,75 @@
-lval* builtin_op(lenv* e, lval* a, char* op) {
+/* enum of arithmetic operators, each builtin passes its own */
+enum { ARITH_ADD, ARITH_SUB, ARITH_MUL, ARITH_DIV };
+
+char* arith_name(int op) {
+  switch (op) {
+    case ARITH_ADD: return "+";
+    case ARITH_SUB: return "-";
+    case ARITH_MUL: return "*";
+    default: return "/";
+  }
+}
+
+lval* builtin_op(lenv* e, lval* a, int op) {
+  /* two fixnums, the most common case, need no type checks */
+  if (a->count == 2 && lval_is_fixnum(a->cell[0]) && lval_is_fixnum(a->cell[1])) {
+    long x = lval_to_num(a->cell[0]);
+    long y = lval_to_num(a->cell[1]);
+    lval_del(a);
+    switch (op) {
+      case ARITH_ADD: return lval_num(x + y);
+      case ARITH_SUB: return lval_num(x - y);
+      case ARITH_MUL: return lval_num(x * y);
+      default: return y == 0 ? lval_err("Division by zero!") : lval_num(x / y);
+    }
+  }
+
   /* ensure all arguments are numbers */
   for (int i = 0; i < a->count; i++) {
-    LASSERT_TYPE(op, a, i, LVAL_NUM);
+    LASSERT_TYPE(arith_name(op), a, i, LVAL_NUM);
   }
 
-  /* pop the first element */
-  lval* x = lval_pop(a, 0);
+  /* accumulate in a plain long, numbers are rarely allocated, see lval_num */
+  long x = lval_to_num(a->cell[0]);
 
   /* if no arguments and sub then perform unary negation */
-  if ((strcmp(op, "-") == 0) && a->count == 0) {
-    x->num = -x->num;
+  if (op == ARITH_SUB && a->count == 1) {
+    x = -x;
   }
 
-  while (a->count > 0) {
-    lval* y = lval_pop(a, 0);
-
-    if (strcmp(op, "+") == 0) { x->num += y->num; }
-    if (strcmp(op, "-") == 0) { x->num -= y->num; }
-    if (strcmp(op, "*") == 0) { x->num *= y->num; }
-    if (strcmp(op, "/") == 0) {
-      if (y->num == 0) {
-        lval_del(x);
-        lval_del(y);
-        x = lval_err("Division by zero!");
+  for (int i = 1; i < a->count; i++) {
+    long y = lval_to_num(a->cell[i]);
+
+    switch (op) {
+      case ARITH_ADD: x += y; break;
+      case ARITH_SUB: x -= y; break;
+      case ARITH_MUL: x *= y; break;
+      case ARITH_DIV:
+        if (y == 0) {
+          lval_del(a);
+          return lval_err("Division by zero!");
+        }
+        x /= y;
         break;
-      }
-      x->num /= y->num;
     }
-
-    lval_del(y);
   }
 
   lval_del(a);
-  return x;
+  return lval_num(x);
 }
 
 lval* builtin_add(lenv* e, lval* a) {
-  return builtin_op(e, a, "+");
+  return builtin_op(e, a, ARITH_ADD);
 }
 
 lval* builtin_sub(lenv* e, lval* a) {
-  return builtin_op(e, a, "-");
+  return builtin_op(e, a, ARITH_SUB);
 }
 
 lval* builtin_mul(lenv* e, lval* a) {
-  return builtin_op(e, a, "*");
+  return builtin_op(e, a, ARITH_MUL);
 }
 
 lval* builtin_div(lenv* e, lval* a) {
-  return builtin_op(e, a, "/");
+  return builtin_op(e, a, ARITH_DIV);
 }
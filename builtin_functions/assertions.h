@@ -8,11 +8,11 @@
 #define LASSERT_TYPE(func, args, index, expect) \
   LASSERT( \
     args, \
-    args->cell[index]->type == expect, \
+    lval_type(args->cell[index]) == expect, \
     "Function '%s' passed incorrect type for argument %i. Got %s, expected %s.", \
     func, \
     index, \
-    ltype_name(args->cell[index]->type), \
+    ltype_name(lval_type(args->cell[index])), \
     ltype_name(expect) \
   );
 
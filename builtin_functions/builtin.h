@@ -6,6 +6,8 @@ Definitions of leesp's built in functions
 #include "arithmetic.h"
 #include "comparison.h"
 #include "list.h"
+#include "memory.h"
+#include "logic.h"
 
 lval* builtin_lambda(lenv* e, lval* a) {
   LASSERT_NUM("\\", a, 2);
@@ -16,9 +18,9 @@ lval* builtin_lambda(lenv* e, lval* a) {
     // first Q expression must only contain symbols
     LASSERT(
       a,
-      (a->cell[0]->cell[i]->type == LVAL_SYM),
+      (lval_type(a->cell[0]->cell[i]) == LVAL_SYM),
       "Cannot define non-symbol. Got %s, expected %s.",
-      ltype_name(a->cell[0]->cell[i]->type),
+      ltype_name(lval_type(a->cell[0]->cell[i])),
       ltype_name(LVAL_SYM)
     );
   }
@@ -27,6 +29,12 @@ lval* builtin_lambda(lenv* e, lval* a) {
   lval* body = lval_pop(a, 0);
   lval_del(a);
 
+  /* address symbols in the body by slot rather than searching every env */
+  lval_resolve(e, formals, body);
+
+  /* compile the body once here rather than on every call */
+  if (vm_enabled && !body->code) { body->code = vm_compile(body); }
+
   return lval_lambda(formals, body);
 }
 
@@ -38,10 +46,10 @@ lval* builtin_var(lenv* e, lval* a, char* func) {
   for (int i = 0; i < syms->count; i++) {
     LASSERT(
       a,
-      (syms->cell[i]->type == LVAL_SYM),
+      (lval_type(syms->cell[i]) == LVAL_SYM),
       "Function '%s' cannot define non-symbol. Got %s, expected %s.",
       func,
-      ltype_name(syms->cell[i]->type),
+      ltype_name(lval_type(syms->cell[i])),
       ltype_name(LVAL_SYM)
     );
   }
@@ -77,57 +85,58 @@ lval* builtin_put(lenv* e, lval* a) {
   return builtin_var(e, a, "=");
 }
 
-lval* builtin_if(lenv* e, lval* a) {
+lval* builtin_if_branch(lenv* e, lval* a) {
+  /* returns the Q-Expression of the branch to take */
   LASSERT_NUM("if", a, 3);
   LASSERT_TYPE("if", a, 0, LVAL_NUM);
   LASSERT_TYPE("if", a, 1, LVAL_QEXPR);
   LASSERT_TYPE("if", a, 2, LVAL_QEXPR);
 
-  lval* x;
-  a->cell[1]->type = LVAL_SEXPR;
-  a->cell[2]->type = LVAL_SEXPR;
+  return lval_take(a, lval_to_num(a->cell[0]) ? 1 : 2);
+}
 
-  if (a->cell[0]->num) {
-    x = lval_eval(e, lval_pop(a, 1));
-  } else {
-    x = lval_eval(e, lval_pop(a, 2));
+lval* builtin_if(lenv* e, lval* a) {
+  /* calls to 'if' are normally evaluated as a special form, see lval/forms.h */
+  lval* x = builtin_if_branch(e, a);
+  if (lval_type(x) == LVAL_ERR) { return x; }
+  return lval_eval_qexpr(e, x);
+}
+
+lval* builtin_load_reader(lenv* e, lreader* r) {
+  /* evaluate each expression as soon as it is read, then free r */
+  lval* x;
+  while ((x = lreader_form(r))) {
+    x = lval_eval(e, x);
+    if (lval_type(x) == LVAL_ERR) { lval_print_ln(x); }
+    lval_del(x);
   }
 
-  lval_del(a);
-  return x;
+  lval* result = r->err ? lval_err("Could not load library %s", r->err) : lval_sexpr();
+  lreader_free(r);
+  return result;
 }
 
 lval* builtin_load(lenv* e, lval* a) {
   LASSERT_NUM("load", a, 1);
   LASSERT_TYPE("load", a, 0, LVAL_STR);
 
-  /* parse file given by string name */
-  mpc_result_t r;
-  if (mpc_parse_contents(a->cell[0]->str, Leesp, &r)) {
-    /* read contents */
-    lval* expr = lval_read(r.output);
-    mpc_ast_delete(r.output);
-
-    /* evaluate each expression */
-    while (expr->count) {
-      lval* x = lval_eval(e, lval_pop(expr, 0));
-      if (x->type == LVAL_ERR) { lval_print_ln(x); }
-      lval_del(x);
+  /* read the file given by string name, mapped if possible */
+  lreader r;
+  FILE* f = NULL;
+  if (!lreader_map(&r, a->cell[0]->str)) {
+    f = fopen(a->cell[0]->str, "rb");
+    if (!f) {
+      lval* err = lval_err("Could not load library %s: error: Unable to open file!\n", a->cell[0]->str);
+      lval_del(a);
+      return err;
     }
-
-    lval_del(expr);
-    lval_del(a);
-    return lval_sexpr();
-  } else {
-    /* get parse error as string */
-    char* err_msg = mpc_err_string(r.error);
-    mpc_err_delete(r.error);
-
-    lval* err = lval_err("Could not load library %s", err_msg);
-    free(err_msg);
-    lval_del(a);
-    return err;
+    lreader_open(&r, a->cell[0]->str, f);
   }
+
+  lval* result = builtin_load_reader(e, &r);
+  if (f) { fclose(f); }
+  lval_del(a);
+  return result;
 }
 
 lval* builtin_print(lenv* e, lval* a) {
@@ -1,56 +1,63 @@
 int lvals_are_equal(lval* x, lval* y);
 
-lval* builtin_comparison(lenv* e, lval* a, char* op) {
-  LASSERT_NUM(op, a, 2);
-  LASSERT_TYPE(op, a, 0, LVAL_NUM);
-  LASSERT_TYPE(op, a, 1, LVAL_NUM);
+/* enum of comparison operators, each builtin passes its own */
+enum { CMP_GT, CMP_LT, CMP_GE, CMP_LE };
+
+char* cmp_name(int op) {
+  switch (op) {
+    case CMP_GT: return ">";
+    case CMP_LT: return "<";
+    case CMP_GE: return ">=";
+    default: return "<=";
+  }
+}
+
+lval* builtin_comparison(lenv* e, lval* a, int op) {
+  LASSERT_NUM(cmp_name(op), a, 2);
+  LASSERT_TYPE(cmp_name(op), a, 0, LVAL_NUM);
+  LASSERT_TYPE(cmp_name(op), a, 1, LVAL_NUM);
+
+  long x = lval_to_num(a->cell[0]);
+  long y = lval_to_num(a->cell[1]);
 
   int r = 0;
-  if (strcmp(op, ">") == 0) {
-    r = (a->cell[0]->num > a->cell[1]->num);
-  } else if (strcmp(op, "<") == 0) {
-    r = (a->cell[0]->num < a->cell[1]->num);
-  } else if (strcmp(op, ">=") == 0) {
-    r = (a->cell[0]->num >= a->cell[1]->num);
-  } else if (strcmp(op, "<=") == 0) {
-    r = (a->cell[0]->num <= a->cell[1]->num);
+  switch (op) {
+    case CMP_GT: r = (x > y); break;
+    case CMP_LT: r = (x < y); break;
+    case CMP_GE: r = (x >= y); break;
+    case CMP_LE: r = (x <= y); break;
   }
   lval_del(a);
   return lval_num(r);
 }
 
 lval* builtin_greater_than(lenv* e, lval* a) {
-  return builtin_comparison(e, a, ">");
+  return builtin_comparison(e, a, CMP_GT);
 }
 
 lval* builtin_less_than(lenv* e, lval* a) {
-  return builtin_comparison(e, a, "<");
+  return builtin_comparison(e, a, CMP_LT);
 }
 
 lval* builtin_greater_than_equal(lenv* e, lval* a) {
-  return builtin_comparison(e, a, ">=");
+  return builtin_comparison(e, a, CMP_GE);
 }
 
 lval* builtin_less_than_equal(lenv* e, lval* a) {
-  return builtin_comparison(e, a, "<=");
+  return builtin_comparison(e, a, CMP_LE);
 }
 
-lval* builtin_equality(lenv* e, lval* a, char* op) {
+lval* builtin_equality(lenv* e, lval* a, char* op, int negate) {
   LASSERT_NUM(op, a, 2);
-  int r = 0;
-  if (strcmp(op, "==") == 0) {
-    r = lvals_are_equal(a->cell[0], a->cell[1]);
-  } else if (strcmp(op, "!=") == 0) {
-    r = !lvals_are_equal(a->cell[0], a->cell[1]);
-  }
+  int r = lvals_are_equal(a->cell[0], a->cell[1]) != negate;
   lval_del(a);
   return lval_num(r);
 }
 
 lval* builtin_equal_to(lenv* e, lval* a) {
-  return builtin_equality(e, a, "==");
+  return builtin_equality(e, a, "==", 0);
 }
 
 lval* builtin_not_equal(lenv* e, lval* a) {
-  return builtin_equality(e, a, "!=");
+  return builtin_equality(e, a, "!=", 1);
 }
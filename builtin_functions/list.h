@@ -8,10 +8,8 @@ lval* builtin_head(lenv* e, lval* a) {
   LASSERT_TYPE("head", a, 0, LVAL_QEXPR);
   LASSERT_NOT_EMPTY("head", a, 0);
 
-  lval* v = lval_take(a, 0);
-  while (v->count > 1) {
-    lval_del(lval_pop(v, 1));
-  }
+  lval* v = lval_unshare(lval_take(a, 0));
+  lval_truncate(v, 1);
   return v;
 }
 
@@ -21,7 +19,7 @@ lval* builtin_tail(lenv* e, lval* a) {
   LASSERT_TYPE("tail", a, 0, LVAL_QEXPR);
   LASSERT_NOT_EMPTY("tail", a, 0);
 
-  lval* v = lval_take(a, 0);
+  lval* v = lval_unshare(lval_take(a, 0));
   lval_del(lval_pop(v, 0));
   return v;
 }
@@ -32,14 +30,20 @@ lval* builtin_list(lenv* e, lval* a) {
   return a;
 }
 
-lval* builtin_eval(lenv* e, lval* a) {
-  /* takes a Q-Expression and evaluates it as if it were a S-Expression */
+lval* builtin_eval_target(lenv* e, lval* a) {
+  /* returns the Q-Expression to be evaluated */
   LASSERT_NUM("eval", a, 1);
   LASSERT_TYPE("eval", a, 0, LVAL_QEXPR);
 
-  lval* x = lval_take(a, 0);
-  x->type = LVAL_SEXPR;
-  return lval_eval(e, x);
+  return lval_take(a, 0);
+}
+
+lval* builtin_eval(lenv* e, lval* a) {
+  /* takes a Q-Expression and evaluates it as if it were a S-Expression */
+  /* calls to 'eval' are normally evaluated as tail calls by lval_eval_call */
+  lval* x = builtin_eval_target(e, a);
+  if (lval_type(x) == LVAL_ERR) { return x; }
+  return lval_eval_qexpr(e, x);
 }
 
 lval* builtin_join(lenv* e, lval* a) {
@@ -57,3 +61,184 @@ lval* builtin_join(lenv* e, lval* a) {
   lval_del(a);
   return x;
 }
+
+lval* builtin_len(lenv* e, lval* a) {
+  /* returns the number of elements in a Q-Expression */
+  LASSERT_NUM("len", a, 1);
+  LASSERT_TYPE("len", a, 0, LVAL_QEXPR);
+
+  lval* x = lval_num(a->cell[0]->count);
+  lval_del(a);
+  return x;
+}
+
+lval* builtin_fst_target(lenv* e, lval* a) {
+  /* returns a Q-Expression holding only the first element, to be evaluated */
+  LASSERT_NUM("fst", a, 1);
+  LASSERT_TYPE("fst", a, 0, LVAL_QEXPR);
+  LASSERT_NOT_EMPTY("fst", a, 0);
+
+  lval* x = lval_add(lval_qexpr(), lval_copy(a->cell[0]->cell[0]));
+  lval_del(a);
+  return x;
+}
+
+lval* builtin_snd_target(lenv* e, lval* a) {
+  /* returns a Q-Expression holding only the second element, to be evaluated */
+  LASSERT_NUM("snd", a, 1);
+  LASSERT_TYPE("snd", a, 0, LVAL_QEXPR);
+  LASSERT(
+    a,
+    a->cell[0]->count >= 2,
+    "Function 'snd' passed %i elements for argument 0, expected at least 2.",
+    a->cell[0]->count
+  );
+
+  lval* x = lval_add(lval_qexpr(), lval_copy(a->cell[0]->cell[1]));
+  lval_del(a);
+  return x;
+}
+
+/* like 'eval (head x)', these evaluate the element they pick out */
+/* and are normally evaluated as tail calls by lval_eval_call */
+
+lval* builtin_fst(lenv* e, lval* a) {
+  lval* x = builtin_fst_target(e, a);
+  if (lval_type(x) == LVAL_ERR) { return x; }
+  return lval_eval_qexpr(e, x);
+}
+
+lval* builtin_snd(lenv* e, lval* a) {
+  lval* x = builtin_snd_target(e, a);
+  if (lval_type(x) == LVAL_ERR) { return x; }
+  return lval_eval_qexpr(e, x);
+}
+
+lval* lval_apply_one(lenv* e, lval* f, lval* x) {
+  /* call f with the single argument x, taking ownership of x */
+  lval* call = lval_add(lval_sexpr(), lval_copy(f));
+  return lval_apply(e, lval_add(call, x));
+}
+
+lval* builtin_map(lenv* e, lval* a) {
+  /* applies a function to the evaluated value of each element */
+  LASSERT_NUM("map", a, 2);
+  LASSERT_TYPE("map", a, 1, LVAL_QEXPR);
+
+  lval* f = a->cell[0];
+  lval* xs = a->cell[1];
+  lval* result = lval_qexpr();
+  lval* err = NULL;
+
+  /* every element is still visited after an error, only the first is returned */
+  for (int i = 0; i < xs->count; i++) {
+    lval* y = lval_apply_one(e, f, lval_eval(e, lval_copy(xs->cell[i])));
+    if (lval_type(y) == LVAL_ERR && !err) {
+      err = y;
+    } else if (err) {
+      lval_del(y);
+    } else {
+      result = lval_add(result, y);
+    }
+  }
+
+  lval_del(a);
+  if (err) {
+    lval_del(result);
+    return err;
+  }
+  return result;
+}
+
+lval* builtin_filter(lenv* e, lval* a) {
+  /* keeps the elements whose evaluated value the function returns non-zero for */
+  LASSERT_NUM("filter", a, 2);
+  LASSERT_TYPE("filter", a, 1, LVAL_QEXPR);
+
+  lval* f = a->cell[0];
+  lval* xs = a->cell[1];
+  lval* result = lval_qexpr();
+  lval* err = NULL;
+
+  for (int i = 0; i < xs->count; i++) {
+    lval* y = lval_apply_one(e, f, lval_eval(e, lval_copy(xs->cell[i])));
+    if (lval_type(y) != LVAL_NUM && !err) {
+      err = lval_type(y) == LVAL_ERR ? lval_copy(y) : lval_err(
+        "Function 'filter' got incorrect type from its function. Got %s, expected %s.",
+        ltype_name(lval_type(y)),
+        ltype_name(LVAL_NUM)
+      );
+    } else if (!err && lval_to_num(y)) {
+      result = lval_add(result, lval_copy(xs->cell[i]));
+    }
+    lval_del(y);
+  }
+
+  lval_del(a);
+  if (err) {
+    lval_del(result);
+    return err;
+  }
+  return result;
+}
+
+lval* builtin_foldl(lenv* e, lval* a) {
+  /* folds the evaluated value of each element into z from the left */
+  LASSERT_NUM("foldl", a, 3);
+  LASSERT_TYPE("foldl", a, 2, LVAL_QEXPR);
+
+  lval* f = a->cell[0];
+  lval* xs = a->cell[2];
+  lval* z = lval_copy(a->cell[1]);
+
+  /* stop at the first error, as the reference definition does when the */
+  /* error in its accumulator argument stops the recursive call */
+  for (int i = 0; i < xs->count && lval_type(z) != LVAL_ERR; i++) {
+    lval* call = lval_add(lval_sexpr(), lval_copy(f));
+    call = lval_add(call, z);
+    call = lval_add(call, lval_eval(e, lval_copy(xs->cell[i])));
+    z = lval_apply(e, call);
+  }
+
+  lval_del(a);
+  return z;
+}
+
+lval* builtin_fold_op(lenv* e, lval* a, char* func, lbuiltin op, long z) {
+  /* folds a builtin operator over a Q-Expression pair by pair, starting from z */
+  /* like the reference foldl, nothing after the first error is evaluated */
+  LASSERT_NUM(func, a, 1);
+  LASSERT_TYPE(func, a, 0, LVAL_QEXPR);
+
+  lval* xs = a->cell[0];
+  lval* result = lval_num(z);
+  for (int i = 0; i < xs->count && lval_type(result) != LVAL_ERR; i++) {
+    lval* x = lval_eval(e, lval_copy(xs->cell[i]));
+    if (lval_type(x) != LVAL_NUM) {
+      lval_del(result);
+      result = lval_type(x) == LVAL_ERR ? lval_copy(x) : lval_err(
+        "Function '%s' passed incorrect type for element %i of argument 0. Got %s, expected %s.",
+        func,
+        i,
+        ltype_name(lval_type(x)),
+        ltype_name(LVAL_NUM)
+      );
+      lval_del(x);
+      break;
+    }
+
+    lval* call = lval_add(lval_sexpr(), result);
+    result = op(e, lval_add(call, x));
+  }
+
+  lval_del(a);
+  return result;
+}
+
+lval* builtin_sum(lenv* e, lval* a) {
+  return builtin_fold_op(e, a, "sum", builtin_add, 0);
+}
+
+lval* builtin_product(lenv* e, lval* a) {
+  return builtin_fold_op(e, a, "product", builtin_mul, 1);
+}
@@ -0,0 +1,84 @@
+/*
+logical functions
+calls to these are normally evaluated as special forms, see lval/forms.h
+*/
+
+lval* builtin_select_clause(lenv* e, lval* a, int from, lval** pick) {
+  /* tests the clauses of a in order, starting from index from */
+  /* returns NULL with the expression of the first that holds in *pick, otherwise an error */
+  for (int i = from; i < a->count; i++) {
+    lval* clause = a->cell[i];
+    lval* c = lval_eval(e, lval_copy(clause->cell[0]));
+    if (lval_type(c) == LVAL_ERR) { return c; }
+    if (lval_type(c) != LVAL_NUM) {
+      lval* err = lval_err(
+        "Function 'select' passed incorrect type for the condition of argument %i. Got %s, expected %s.",
+        i - from,
+        ltype_name(lval_type(c)),
+        ltype_name(LVAL_NUM)
+      );
+      lval_del(c);
+      return err;
+    }
+
+    int holds = lval_to_num(c) != 0;
+    lval_del(c);
+    if (holds) {
+      *pick = clause->cell[1];
+      return NULL;
+    }
+  }
+  return lval_err("No Selection Found");
+}
+
+lval* builtin_select_target(lenv* e, lval* a) {
+  /* returns a Q-Expression holding the expression of the first clause that holds, to be evaluated */
+  for (int i = 0; i < a->count; i++) {
+    LASSERT_TYPE("select", a, i, LVAL_QEXPR);
+    LASSERT(
+      a,
+      a->cell[i]->count >= 2,
+      "Function 'select' passed %i elements for argument %i, expected at least 2.",
+      a->cell[i]->count,
+      i
+    );
+  }
+
+  lval* pick;
+  lval* err = builtin_select_clause(e, a, 0, &pick);
+  if (err) {
+    lval_del(a);
+    return err;
+  }
+
+  lval* x = lval_add(lval_qexpr(), lval_copy(pick));
+  lval_del(a);
+  return x;
+}
+
+lval* builtin_select(lenv* e, lval* a) {
+  /* takes clauses of {condition expression} and evaluates the expression */
+  /* of the first whose condition is non-zero */
+  lval* x = builtin_select_target(e, a);
+  if (lval_type(x) == LVAL_ERR) { return x; }
+  return lval_eval_qexpr(e, x);
+}
+
+lval* builtin_logic(lenv* e, lval* a, char* func, int stop) {
+  /* returns the first argument whose truth is stop, otherwise the last */
+  for (int i = 0; i < a->count; i++) {
+    LASSERT_TYPE(func, a, i, LVAL_NUM);
+  }
+
+  int i = 0;
+  while (i < a->count - 1 && (lval_to_num(a->cell[i]) != 0) != stop) { i++; }
+  return lval_take(a, i);
+}
+
+lval* builtin_and(lenv* e, lval* a) {
+  return builtin_logic(e, a, "and", 0);
+}
+
+lval* builtin_or(lenv* e, lval* a) {
+  return builtin_logic(e, a, "or", 1);
+}
@@ -0,0 +1,25 @@
+/*
+memory management related functions
+*/
+
+/* a function is only called when given arguments, so this ignores its own */
+
+lval* builtin_pool_stats(lenv* e, lval* a) {
+  /* returns {size slabs used free} for every size class with a slab */
+  lval_del(a);
+
+  lval* x = lval_qexpr();
+  for (int c = 0; c < POOL_CLASSES; c++) {
+    if (!pool[c].slabs) { continue; }
+    long size = (c + 1) * POOL_GRANULE;
+    long blocks = pool[c].slabs * (POOL_SLAB_SIZE / size);
+
+    lval* stats = lval_qexpr();
+    stats = lval_add(stats, lval_num(size));
+    stats = lval_add(stats, lval_num(pool[c].slabs));
+    stats = lval_add(stats, lval_num(pool[c].in_use));
+    stats = lval_add(stats, lval_num(blocks - pool[c].in_use));
+    x = lval_add(x, stats);
+  }
+  return x;
+}
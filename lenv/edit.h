@@ -1,56 +1,110 @@
 void lenv_del(lenv* e) {
-  for (int i = 0; i < e->count; i++) {
-    free(e->syms[i]);
-    lval_del(e->vals[i]);
+  for (int i = 0; i < e->capacity; i++) {
+    if (e->entries[i].sym) {
+      sym_info_of(e->entries[i].sym)->binds--;
+      lval_del(e->entries[i].val);
+    }
   }
-  free(e->syms);
-  free(e->vals);
-  free(e);
-}
-
-lenv* lenv_copy(lenv* e) {
-  lenv* n = malloc(sizeof(lenv));
-  n->par = e-> par;
-  n->count = e->count;
-  n->syms = malloc(sizeof(char*) * n->count);
-  n->vals = malloc(sizeof(lval*) * n->count);
-  for (int i = 0; i < e->count; i++) {
-    n->syms[i] = malloc(strlen(e->syms[i]) + 1);
-    strcpy(n->syms[i], e->syms[i]);
-    n->vals[i] = lval_copy(e->vals[i]);
+  free(e->entries);
+  pool_free(e, sizeof(lenv));
+}
+
+lenv_entry* lenv_find(lenv* e, char* sym, unsigned long hash) {
+  /* returns the entry holding sym, or the empty entry where it belongs */
+  /* symbols are interned so a pointer compare is enough */
+  int mask = e->capacity - 1;
+  int i = hash & mask;
+  while (e->entries[i].sym && e->entries[i].sym != sym) {
+    i = (i + 1) & mask;
   }
-  return n;
+  return &e->entries[i];
 }
 
-lval* lenv_get(lenv* e, lval* k) {
-  for (int i = 0; i < e->count; i++) {
-    if (strcmp(e->syms[i], k->sym) == 0) {
-      return lval_copy(e->vals[i]);
+void lenv_grow(lenv* e) {
+  /* double the capacity and reinsert every entry */
+  int old_capacity = e->capacity;
+  lenv_entry* old = e->entries;
+
+  e->capacity = old_capacity ? old_capacity * 2 : 8;
+  e->entries = calloc(e->capacity, sizeof(lenv_entry));
+  for (int i = 0; i < old_capacity; i++) {
+    if (old[i].sym) {
+      *lenv_find(e, old[i].sym, old[i].hash) = old[i];
     }
   }
-  // symbol not found in current env, check parent
-  if (e->par) {
-    return lenv_get(e->par, k);
-  } else {
-    return lval_err("unbound symbol '%s'", k->sym);
+  free(old);
+}
+
+void lenv_reserve(lenv* e, int n) {
+  /* make room for n bindings so putting them never grows the table */
+  while (n * 4 > e->capacity * 3) { lenv_grow(e); }
+}
+
+int lenv_shadows(lenv* e, lenv* x) {
+  /* whether e binds every symbol that x binds */
+  if (x->count > e->count) { return 0; }
+  for (int i = 0; i < x->capacity; i++) {
+    lenv_entry* entry = &x->entries[i];
+    if (entry->sym && !lenv_find(e, entry->sym, entry->hash)->sym) { return 0; }
+  }
+  return 1;
+}
+
+lenv* lenv_at(lenv* e, lval* k) {
+  /* the env the address of k names when evaluated in e, if any */
+  if (k->addr == LVAL_ADDR_FRAME) { return e; }
+  if (k->addr == LVAL_ADDR_GLOBAL) { return e->top; }
+  return NULL;
+}
+
+lenv_entry* lenv_find_at(lenv* e, lval* k) {
+  /* returns the entry at the address of k if it still holds k, else NULL */
+  lenv* x = lenv_at(e, k);
+  if (!x || k->slot >= x->capacity) { return NULL; }
+
+  lenv_entry* entry = &x->entries[k->slot];
+  if (entry->sym != k->sym) { return NULL; }
+
+  // an outer binding is only visible if no env in between shadows it
+  if (x != e && sym_info_of(k->sym)->binds != 1) { return NULL; }
+  return entry;
+}
+
+lval* lenv_get(lenv* e, lval* k) {
+  lenv_entry* entry = lenv_find_at(e, k);
+  if (entry) { return lval_copy(entry->val); }
+
+  lenv* at = lenv_at(e, k);
+  while (e) {
+    if (e->count) {
+      entry = lenv_find(e, k->sym, k->hash);
+      if (entry->sym) {
+        // keep the address current if the env has grown since it was resolved
+        if (e == at) { k->slot = entry - e->entries; }
+        return lval_copy(entry->val);
+      }
+    }
+    // symbol not found in current env, check parent
+    e = e->par;
   }
+  return lval_err("unbound symbol '%s'", k->sym);
 }
 
 void lenv_put(lenv* e, lval* k, lval* v) {
+  /* keep the table at most three quarters full */
+  if ((e->count + 1) * 4 > e->capacity * 3) { lenv_grow(e); }
+
   /* add to the provided environment */
-  for (int i = 0; i < e->count; i++) {
-    if (strcmp(e->syms[i], k->sym) == 0) {
-      lval_del(e->vals[i]);
-      e->vals[i] = lval_copy(v);
-      return;
-    }
+  lenv_entry* entry = lenv_find(e, k->sym, k->hash);
+  if (entry->sym) {
+    lval_del(entry->val);
+    entry->val = lval_copy(v);
+    return;
   }
 
   e->count++;
-  e->vals = realloc(e->vals, sizeof(lval*) * e->count);
-  e->syms = realloc(e->syms, sizeof(char*) * e->count);
-
-  e->vals[e->count - 1] = lval_copy(v);
-  e->syms[e->count - 1] = malloc(strlen(k->sym) + 1);
-  strcpy(e->syms[e->count - 1], k->sym);
+  sym_info_of(k->sym)->binds++;
+  entry->sym = k->sym;
+  entry->hash = k->hash;
+  entry->val = lval_copy(v);
 }
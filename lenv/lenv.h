@@ -1,16 +1,23 @@
 /*
 Create an environment to store relationships between symbols and values
-This is a naive approach of two equal length lists
+Symbols are stored in an open addressing hash table keyed by the hash
+precomputed when the symbol lval was constructed, and compared by their
+interned name pointer
+Lambdas do not hold an environment, each call binds its arguments in a new
+one, see lval_bind
+Every env also keeps the outermost env of the chain it was entered into, so
+symbols resolved to a global slot can be found without walking the chain
 */
 
 #include "edit.h"
 
 lenv* lenv_new(void) {
-  lenv* e = malloc(sizeof(lenv));
+  lenv* e = pool_alloc(sizeof(lenv));
   e->par = NULL;
+  e->top = e;
   e->count = 0;
-  e->syms = NULL;
-  e->vals = NULL;
+  e->capacity = 0;
+  e->entries = NULL;
   return e;
 }
 
@@ -19,3 +26,5 @@ void lenv_def(lenv* e, lval* k, lval* v) {
   while (e->par) { e = e->par; }
   lenv_put(e, k, v);
 }
+
+#include "resolve.h"
@@ -0,0 +1,60 @@
+/*
+Resolver run over the body of a lambda when it is created
+A call's env has the caller's env as its parent, so the only bindings whose
+place is known ahead of time are the lambda's own formals and the outermost
+env. Symbols naming a formal are given the slot it will be bound at in the
+call's env, and all others the slot they have in the outermost env.
+lenv_get tries that slot before searching every env, and checks it still
+holds the symbol, so a stale or wrong address only costs the search.
+*/
+
+void lval_resolve_cells(lval* v, lenv* frame, lenv* top) {
+  for (int i = 0; i < v->count; i++) {
+    lval* x = v->cell[i];
+
+    switch (lval_type(x)) {
+      case LVAL_SYM: {
+        lenv_entry* entry = frame->count ? lenv_find(frame, x->sym, x->hash) : NULL;
+        if (entry && entry->sym) {
+          x->addr = LVAL_ADDR_FRAME;
+          x->slot = entry - frame->entries;
+          break;
+        }
+
+        // globals may not be defined yet, lenv_get fills in the slot once they are
+        entry = top->count ? lenv_find(top, x->sym, x->hash) : NULL;
+        x->addr = LVAL_ADDR_GLOBAL;
+        x->slot = entry && entry->sym ? entry - top->entries : 0;
+        break;
+      }
+
+      /* Q-Expressions in the body are usually branches evaluated in the same env */
+      case LVAL_SEXPR:
+      case LVAL_QEXPR:
+        lval_resolve_cells(x, frame, top);
+        break;
+    }
+  }
+}
+
+void lval_resolve(lenv* e, lval* formals, lval* body) {
+  /* bind the formals in order into a table of the same size as lval_bind */
+  /* does, so they land in the same slots */
+  int count = formals->count;
+  for (int i = 0; i < formals->count; i++) {
+    if (strcmp(formals->cell[i]->sym, "&") == 0) { count--; }
+  }
+
+  lenv* frame = lenv_new();
+  lval* placeholder = lval_num(0);
+  lenv_reserve(frame, count);
+  for (int i = 0; i < formals->count; i++) {
+    if (strcmp(formals->cell[i]->sym, "&") == 0) { continue; }
+    lenv_put(frame, formals->cell[i], placeholder);
+  }
+
+  lval_resolve_cells(body, frame, e->top);
+
+  lval_del(placeholder);
+  lenv_del(frame);
+}
@@ -1,6 +1,39 @@
 /* enum of possible lval types */
 enum { LVAL_ERR, LVAL_NUM, LVAL_SYM, LVAL_STR, LVAL_FUN, LVAL_SEXPR, LVAL_QEXPR };
 
+/* enum of symbol addresses, the slot is in the env the address names */
+enum {
+  LVAL_ADDR_NONE,   /* unresolved, search every env */
+  LVAL_ADDR_FRAME,  /* the env the symbol is evaluated in */
+  LVAL_ADDR_GLOBAL  /* the outermost env */
+};
+
+/*
+Numbers that fit in all but one bit of a long are stored in the lval
+pointer itself, marked by setting its lowest bit, so they never allocate.
+Real lvals are always at least 8 byte aligned so their low bit is clear.
+Use lval_type and lval_to_num rather than reading type and num directly.
+*/
+#define LVAL_FIXNUM_MIN (LONG_MIN / 2)
+#define LVAL_FIXNUM_MAX (LONG_MAX / 2)
+
+int lval_is_fixnum(lval* v) {
+  return (uintptr_t)v & 1;
+}
+
+lval* lval_fixnum(long x) {
+  return (lval*)(((uintptr_t)x << 1) | 1);
+}
+
+int lval_type(lval* v) {
+  return lval_is_fixnum(v) ? LVAL_NUM : v->type;
+}
+
+long lval_to_num(lval* v) {
+  /* the shift is arithmetic so negative numbers keep their sign */
+  return lval_is_fixnum(v) ? (long)((intptr_t)v >> 1) : v->num;
+}
+
 char* ltype_name(int t) {
   switch(t) {
     case LVAL_ERR: return "Error";
@@ -13,3 +46,13 @@ char* ltype_name(int t) {
     default: return "Unknown";
   }
 }
+
+unsigned long sym_hash(char* s) {
+  /* FNV-1a, computed once when a symbol is constructed */
+  unsigned long h = 2166136261UL;
+  while (*s) {
+    h ^= (unsigned char)*s++;
+    h *= 16777619UL;
+  }
+  return h;
+}
@@ -0,0 +1,168 @@
+/*
+Cell buffers shared between S and Q-Expressions
+An expression sees count cells starting at its cell pointer, which points
+somewhere inside a reference counted buffer. Taking the head or tail of a
+list makes a new expression over the same buffer, and joining writes in
+place whenever nothing has been added past that end of the expression
+already, so older versions of a list are never copied to build newer ones.
+A shared buffer is only written into when the cells added cannot reach it,
+otherwise it would come to own itself and never be freed.
+Buffers grow at whichever end they are joined onto, so building a list
+from the back with join behaves like consing onto the front of a list.
+The buffer owns every non-NULL cell from first up to used, whichever
+expressions can see it.
+*/
+
+void lval_del(lval* v);
+lval* lval_copy(lval* v);
+
+lcells* lcells_new(int capacity) {
+  lcells* b = malloc(sizeof(lcells) + sizeof(lval*) * capacity);
+  b->refs = 1;
+  b->first = 0;
+  b->used = 0;
+  b->capacity = capacity;
+  return b;
+}
+
+void lcells_release(lcells* b) {
+  if (--b->refs > 0) { return; }
+
+  for (int i = b->first; i < b->used; i++) {
+    if (b->cells[i]) { lval_del(b->cells[i]); }
+  }
+  free(b);
+}
+
+int lcells_capacity(int n) {
+  /* grow geometrically so repeated joins are amortised */
+  int capacity = 4;
+  while (capacity < n) { capacity *= 2; }
+  return capacity;
+}
+
+void lval_own_cells(lval* v) {
+  /* give v, which must not be shared, a buffer no other expression can see */
+  if (!v->buf || v->buf->refs == 1) { return; }
+
+  lcells* b = lcells_new(v->count);
+  for (int i = 0; i < v->count; i++) {
+    b->cells[i] = lval_copy(v->cell[i]);
+  }
+  b->used = v->count;
+
+  lcells_release(v->buf);
+  v->buf = b;
+  v->cell = b->cells;
+}
+
+int lcells_place(int capacity, int count, int n, int front) {
+  /* where count cells go in a buffer of capacity with room for n more */
+  /* at the front or back, the free space past that is split between */
+  /* both ends so adding at the other end next does not move them again */
+  int slack = (capacity - count - n) / 2;
+  if (slack > count) { slack = count; }
+  return front ? capacity - count - slack : slack;
+}
+
+void lval_rebuffer(lval* v, int n, int front) {
+  /* move the cells of v, which must not be shared, into a buffer with room */
+  /* for n more cells before them if front is set, otherwise after them */
+  lcells* b = v->buf;
+  int start = b ? v->cell - b->cells : 0;
+
+  if (!b || b->refs > 1) {
+    lcells* x = lcells_new(lcells_capacity(v->count * 2 + n));
+    int to = lcells_place(x->capacity, v->count, n, front);
+    for (int i = 0; i < v->count; i++) {
+      x->cells[to + i] = lval_copy(v->cell[i]);
+    }
+    x->first = to;
+    x->used = to + v->count;
+
+    if (b) { lcells_release(b); }
+    v->buf = x;
+    v->cell = x->cells + to;
+    return;
+  }
+
+  // nothing else sees this buffer, so drop the cells outside v
+  for (int i = b->first; i < b->used; i++) {
+    if ((i < start || i >= start + v->count) && b->cells[i]) { lval_del(b->cells[i]); }
+  }
+
+  // grow unless there is room for v at least twice over
+  if (v->count * 2 + n > b->capacity) {
+    int capacity = lcells_capacity(v->count * 2 + n);
+    b = realloc(b, sizeof(lcells) + sizeof(lval*) * capacity);
+    b->capacity = capacity;
+  }
+
+  int to = lcells_place(b->capacity, v->count, n, front);
+  memmove(b->cells + to, b->cells + start, sizeof(lval*) * v->count);
+  b->first = to;
+  b->used = to + v->count;
+  v->buf = b;
+  v->cell = b->cells + to;
+}
+
+int lcells_reaches(lval* x, lcells* b, int* budget) {
+  /* whether x can reach the buffer b, taking running out of budget as a yes */
+  if (lval_is_fixnum(x)) { return 0; }
+  if (--*budget < 0) { return 1; }
+
+  switch (x->type) {
+    case LVAL_FUN:
+      if (x->builtin) { return 0; }
+      if (lcells_reaches(x->formals, b, budget) || lcells_reaches(x->body, b, budget)) { return 1; }
+      return x->fn && (lcells_reaches(x->fn, b, budget) || lcells_reaches(x->args, b, budget));
+
+    case LVAL_SEXPR:
+    case LVAL_QEXPR:
+      if (x->code) {
+        for (int i = 0; i < x->code->const_count; i++) {
+          if (lcells_reaches(x->code->consts[i], b, budget)) { return 1; }
+        }
+      }
+      if (!x->buf) { return 0; }
+      if (x->buf == b) { return 1; }
+
+      // the whole buffer is owned, not just the cells x sees
+      for (int i = x->buf->first; i < x->buf->used; i++) {
+        if (x->buf->cells[i] && lcells_reaches(x->buf->cells[i], b, budget)) { return 1; }
+      }
+      return 0;
+  }
+  return 0;
+}
+
+int lcells_can_add(lcells* b, lval** add, int n) {
+  /* whether the n cells at add can be written into b in place */
+  if (b->refs == 1) { return 1; }
+  if (!add) { return 0; }
+
+  // a walk that would cost more than the cells added gives up and copies instead
+  int budget = n * 4 + 64;
+  for (int i = 0; i < n; i++) {
+    if (lcells_reaches(add[i], b, &budget)) { return 0; }
+  }
+  return 1;
+}
+
+void lval_reserve(lval* v, lval** add, int n) {
+  /* make room to add the n cells at add, or NULL if not yet known, after v */
+  /* v must not be shared, and afterwards the end of v is always the end of */
+  /* the used part of its buffer */
+  lcells* b = v->buf;
+  if (b && v->cell + v->count == b->cells + b->used && b->used + n <= b->capacity
+      && lcells_can_add(b, add, n)) { return; }
+  lval_rebuffer(v, n, 0);
+}
+
+void lval_reserve_front(lval* v, lval** add, int n) {
+  /* make room to add the n cells at add before v, which must not be shared */
+  /* afterwards the start of v is always the first used cell of its buffer */
+  lcells* b = v->buf;
+  if (b && v->cell == b->cells + b->first && b->first >= n && lcells_can_add(b, add, n)) { return; }
+  lval_rebuffer(v, n, 1);
+}
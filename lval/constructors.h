@@ -1,9 +1,31 @@
-lenv* lenv_new(void);
+lval* lval_copy(lval* v);
+
+size_t lval_size(int type) {
+  /* bytes needed for the header plus the payload used by type */
+  switch (type) {
+    case LVAL_NUM: return offsetof(lval, num) + sizeof(long);
+    case LVAL_ERR: return offsetof(lval, err) + sizeof(char*);
+    case LVAL_STR: return offsetof(lval, str) + sizeof(char*);
+    case LVAL_SYM: return offsetof(lval, slot) + sizeof(int);
+    case LVAL_FUN: return offsetof(lval, fixed) + sizeof(int);
+    default: return offsetof(lval, code) + sizeof(chunk*);
+  }
+}
+
+lval* lval_new(int type) {
+  /* every lval starts with a single reference owned by the caller */
+  lval* v = pool_alloc(lval_size(type));
+  v->type = type;
+  v->ref = 1;
+  return v;
+}
 
 lval* lval_num(long x) {
   /* construct a pointer to a new Number lval */
-  lval* v = malloc(sizeof(lval));
-  v->type = LVAL_NUM;
+  if (x >= LVAL_FIXNUM_MIN && x <= LVAL_FIXNUM_MAX) { return lval_fixnum(x); }
+
+  // too large to tag, so fall back to the heap
+  lval* v = lval_new(LVAL_NUM);
   v->num = x;
   return v;
 }
@@ -11,8 +33,7 @@ lval* lval_num(long x) {
 lval* lval_err(char* fmt, ...) {
   /* construct a pointer to a new Error lval */
   int error_size = 512;
-  lval* v = malloc(sizeof(lval));
-  v->type = LVAL_ERR;
+  lval* v = lval_new(LVAL_ERR);
   v->err = malloc(error_size);
 
   va_list va;
@@ -26,17 +47,17 @@ lval* lval_err(char* fmt, ...) {
 
 lval* lval_sym(char* s) {
   /* construct a pointer to a new Symbol lval */
-  lval* v = malloc(sizeof(lval));
-  v->type = LVAL_SYM;
-  v->sym = malloc(strlen(s) + 1);
-  strcpy(v->sym, s);
+  lval* v = lval_new(LVAL_SYM);
+  v->hash = sym_hash(s);
+  v->sym = sym_intern(s, v->hash);
+  v->addr = LVAL_ADDR_NONE;
+  v->slot = 0;
   return v;
 }
 
 lval* lval_str(char* s) {
   /* constuct a pointer to a new String lval */
-  lval* v = malloc(sizeof(lval));
-  v->type = LVAL_STR;
+  lval* v = lval_new(LVAL_STR);
   v->str = malloc(strlen(s) + 1);
   strcpy(v->str, s);
   return v;
@@ -44,37 +65,53 @@ lval* lval_str(char* s) {
 
 lval* lval_fun(lbuiltin func) {
   /* constuct a pointer to a new Function lval */
-  lval* v = malloc(sizeof(lval));
-  v->type = LVAL_FUN;
+  lval* v = lval_new(LVAL_FUN);
   v->builtin = func;
   return v;
 }
 
 lval* lval_sexpr(void) {
   /* construct a pointer to a new S-Expression lval */
-  lval* v = malloc(sizeof(lval));
-  v->type = LVAL_SEXPR;
+  lval* v = lval_new(LVAL_SEXPR);
   v->count = 0;
+  v->buf = NULL;
   v->cell = NULL;
+  v->code = NULL;
   return v;
 }
 
 lval* lval_qexpr(void) {
   /* construct a pointer to a new Q-Expression  */
-  lval* v = malloc(sizeof(lval));
-  v->type = LVAL_QEXPR;
+  lval* v = lval_new(LVAL_QEXPR);
   v->count = 0;
+  v->buf = NULL;
   v->cell = NULL;
+  v->code = NULL;
   return v;
 }
 
 lval* lval_lambda(lval* formals, lval* body) {
   /* construct a pointer to a new lambda function lval */
-  lval* v = malloc(sizeof(lval));
-  v->type = LVAL_FUN;
+  static char* amp = NULL;
+  if (!amp) { amp = sym_intern("&", sym_hash("&")); }
+
+  lval* v = lval_new(LVAL_FUN);
   v->builtin = NULL;
-  v->env = lenv_new();
   v->formals = formals;
   v->body = body;
+  v->fn = NULL;
+  v->args = NULL;
+
+  /* counted once here so calls need not look for '&' */
+  v->fixed = 0;
+  while (v->fixed < formals->count && formals->cell[v->fixed]->sym != amp) { v->fixed++; }
+  return v;
+}
+
+lval* lval_partial(lval* fn, lval* args, lval* formals) {
+  /* construct a pointer to a new partial application of lambda fn */
+  lval* v = lval_lambda(formals, lval_copy(fn->body));
+  v->fn = lval_copy(fn);
+  v->args = args;
   return v;
 }
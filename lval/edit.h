@@ -1,43 +1,62 @@
-void lenv_del(lenv* e);
-lenv* lenv_copy(lenv* e);
+chunk* chunk_retain(chunk* c);
+void chunk_release(chunk* c);
+
+lval* lval_new(int type);
+size_t lval_size(int type);
 
 void lval_del(lval* v) {
+  /* fixnums are not allocated, otherwise only free once the last reference is dropped */
+  if (lval_is_fixnum(v)) { return; }
+  if (--v->ref > 0) { return; }
+
   switch (v->type) {
     case LVAL_NUM: break;
     case LVAL_ERR: free(v->err); break;
-    case LVAL_SYM: free(v->sym); break;
+    case LVAL_SYM: break;
     case LVAL_STR: free(v->str); break;
 
     case LVAL_FUN:
       if (!v->builtin) {
-        lenv_del(v->env);
         lval_del(v->formals);
         lval_del(v->body);
+        if (v->fn) {
+          lval_del(v->fn);
+          lval_del(v->args);
+        }
       }
       break;
 
     /* if Qexpr or Sexpr, delete all elements inside */
     case LVAL_QEXPR:
     case LVAL_SEXPR:
-      for (int i = 0; i < v-> count; i++) {
-        lval_del(v->cell[i]);
-      }
-      free(v->cell);
+      if (v->buf) { lcells_release(v->buf); }
+      if (v->code) { chunk_release(v->code); }
     break;
   }
-  free(v);
+  pool_free(v, lval_size(v->type));
 }
 
-lval* lval_add(lval* v, lval* x) {
-  v->count++;
-  v->cell = realloc(v->cell, sizeof(lval*) * v->count);
-  v->cell[v->count - 1] = x;
-  return v;
+void lval_drop_code(lval* v) {
+  /* compiled code no longer matches the cells once they change */
+  if (v->code) {
+    chunk_release(v->code);
+    v->code = NULL;
+  }
 }
 
 lval* lval_copy(lval* v) {
-  lval* x = malloc(sizeof(lval));
-  x->type = v->type;
+  /* lvals are shared rather than duplicated, see lval_unshare */
+  if (lval_is_fixnum(v)) { return v; }
+  v->ref++;
+  return v;
+}
+
+lval* lval_unshare(lval* v) {
+  /* return v if this is the only reference, otherwise a private copy of it */
+  /* the copy is shallow, any cells it holds are shared with the original */
+  if (lval_is_fixnum(v) || v->ref == 1) { return v; }
+
+  lval* x = lval_new(v->type);
 
   switch (v->type) {
     /* copy numbers directly */
@@ -48,9 +67,11 @@ lval* lval_copy(lval* v) {
         x->builtin = v->builtin;
       } else {
         x->builtin = NULL;
-        x->env = lenv_copy(v->env);
         x->formals = lval_copy(v->formals);
         x->body = lval_copy(v->body);
+        x->fn = v->fn ? lval_copy(v->fn) : NULL;
+        x->args = v->args ? lval_copy(v->args) : NULL;
+        x->fixed = v->fixed;
       }
       break;
 
@@ -61,8 +82,11 @@ lval* lval_copy(lval* v) {
       break;
 
     case LVAL_SYM:
-      x->sym = malloc(strlen(v->sym) + 1);
-      strcpy(x->sym, v->sym);
+      /* symbols are interned so only the pointer needs copying */
+      x->sym = v->sym;
+      x->hash = v->hash;
+      x->addr = v->addr;
+      x->slot = v->slot;
       break;
     
     case LVAL_STR:
@@ -70,44 +94,107 @@ lval* lval_copy(lval* v) {
       strcpy(x->str, v->str);
       break;
 
-    /* copy lists */
+    /* lists share their cells, see lval_own_cells */
     case LVAL_SEXPR:
     case LVAL_QEXPR:
       x->count = v->count;
-      x->cell = malloc(sizeof(lval*) * x->count);
-      for (int i = 0; i < x->count; i++) {
-        x->cell[i] = lval_copy(v->cell[i]);
-      }
+      x->buf = v->buf;
+      x->cell = v->cell;
+      if (x->buf) { x->buf->refs++; }
+      x->code = v->code ? chunk_retain(v->code) : NULL;
     break;
   }
 
+  // the original is still referenced elsewhere so is never freed here
+  v->ref--;
   return x;
 }
 
+lval* lval_add(lval* v, lval* x) {
+  v = lval_unshare(v);
+  lval_drop_code(v);
+  lval_reserve(v, &x, 1);
+  v->cell[v->count++] = x;
+  v->buf->used++;
+  return v;
+}
+
 lval* lval_pop(lval* v, int i) {
-  lval* x = v->cell[i];
+  /* v is modified in place so must not be shared */
+  lval_drop_code(v);
+
+  if (i == 0 || i == v->count - 1) {
+    /* popping either end only moves that end, and keeps any shared cells */
+    lval* x = v->cell[i];
+    lcells* b = v->buf;
+    if (b->refs > 1) {
+      x = lval_copy(x);
+    } else {
+      v->cell[i] = NULL;
+      if (i == 0 && v->cell == b->cells + b->first) { b->first++; }
+      else if (i && v->cell + v->count == b->cells + b->used) { b->used--; }
+    }
+    if (i == 0) { v->cell++; }
+    v->count--;
+    return x;
+  }
 
   /* shift memory after item at i over the top */
+  lval_own_cells(v);
+  lval* x = v->cell[i];
   memmove(&v->cell[i], &v->cell[i+1], sizeof(lval*) * (v->count - i -1));
-  v->count--;
-
-  /* reallocate the memory used */
-  v->cell = realloc(v->cell, sizeof(lval*) * v->count);
-
+  v->cell[--v->count] = NULL;
   return x;
 }
 
+void lval_truncate(lval* v, int n) {
+  /* keep only the first n cells of v, which must not be shared */
+  lval_drop_code(v);
+  if (v->buf && v->buf->refs > 1) {
+    v->count = n;
+    return;
+  }
+  while (v->count > n) { lval_del(lval_pop(v, v->count - 1)); }
+}
+
 lval* lval_take(lval* v, int i) {
-  lval* x = lval_pop(v, i);
+  lval* x = lval_copy(v->cell[i]);
   lval_del(v);
   return x;
 }
 
 lval* lval_join(lval* x, lval* y) {
-  while (y->count) {
-    x = lval_add(x, lval_pop(y, 0));
+  /* the cells of the shorter list are added onto the end of the longer one */
+  lval* from = x->count < y->count ? x : y;
+  lval* v = from == x ? y : x;
+  if (from->count == 0) {
+    lval_del(from);
+    return v;
   }
 
-  lval_del(y);
-  return x;
+  v = lval_unshare(v);
+  lval_drop_code(v);
+
+  lval** to;
+  if (from == y) {
+    lval_reserve(v, from->cell, from->count);
+    to = v->cell + v->count;
+    v->buf->used += from->count;
+  } else {
+    lval_reserve_front(v, from->cell, from->count);
+    v->cell -= from->count;
+    v->buf->first -= from->count;
+    to = v->cell;
+  }
+  v->count += from->count;
+
+  // cells can be moved rather than copied when nothing else sees them
+  int move = from->ref == 1 && from->buf->refs == 1;
+  for (int i = 0; i < from->count; i++) {
+    to[i] = move ? from->cell[i] : lval_copy(from->cell[i]);
+    if (move) { from->cell[i] = NULL; }
+  }
+
+  lval_del(from);
+  return v;
 }
@@ -1,120 +1,272 @@
 /* forward declarations */
 void lenv_put(lenv* e, lval* k, lval* v);
 lval* lenv_get(lenv* e, lval* k);
+lenv* lenv_new(void);
+void lenv_reserve(lenv* e, int n);
+void lenv_del(lenv* e);
+int lenv_shadows(lenv* e, lenv* x);
 
+lval* builtin_if(lenv* e, lval* a);
+lval* builtin_if_branch(lenv* e, lval* a);
 lval* builtin_eval(lenv* e, lval* a);
+lval* builtin_eval_target(lenv* e, lval* a);
+lval* builtin_fst(lenv* e, lval* a);
+lval* builtin_fst_target(lenv* e, lval* a);
+lval* builtin_snd(lenv* e, lval* a);
+lval* builtin_snd_target(lenv* e, lval* a);
+lval* builtin_select_target(lenv* e, lval* a);
 lval* builtin_list(lenv* e, lval* a);
 
-lval* lval_call(lenv* e, lval* f, lval* a) {
-  if (f->builtin) { return f->builtin(e, a); }
+extern int vm_enabled;
+chunk* vm_compile(lval* v);
+lval* vm_eval(lenv* e, lval* v);
 
+/*
+Calls in tail position do not recurse. Instead lval_eval_call hands back
+the Q-Expression to evaluate next and the environment to evaluate it in,
+and the caller's loop carries on with those. Environments entered this way
+are kept in an lframes until the loop is done, as later ones see them as
+their parent.
+A frame is only dropped once the frame entered after it binds every symbol
+it does. Mutual tail recursion through functions with different formals,
+such as {even n} calling {odd m}, leaves every frame visible under dynamic
+scope, so it keeps one env per call and only the C stack stays constant.
+*/
+typedef struct {
+  int count;
+  int capacity;
+  lenv** envs;
+} lframes;
+
+void lframes_enter(lframes* frames, lenv* e, lenv* par) {
+  /* a frame is no longer visible once every binding in it is shadowed by e */
+  while (frames->count && frames->envs[frames->count - 1] == par && lenv_shadows(e, par)) {
+    frames->count--;
+    par = par->par;
+    lenv_del(frames->envs[frames->count]);
+  }
+
+  e->par = par;
+  e->top = par->top;
+  if (frames->count == frames->capacity) {
+    frames->capacity = frames->capacity ? frames->capacity * 2 : 8;
+    frames->envs = realloc(frames->envs, sizeof(lenv*) * frames->capacity);
+  }
+  frames->envs[frames->count++] = e;
+}
+
+void lframes_del(lframes* frames) {
+  while (frames->count) { lenv_del(frames->envs[--frames->count]); }
+  free(frames->envs);
+}
+
+lval* lval_bind(lenv* e, lval* f, lval* a, lenv** env) {
+  /* bind arguments a to the formals of lambda f in a new env, leaving f as it is */
+  /* returns NULL with the env in *env once every formal is bound, */
+  /* otherwise the result of the call */
   int given = a->count;
   int total = f->formals->count;
 
-  while (a->count) {
-    if (f->formals->count == 0) {
-      lval_del(a);
-      return lval_err(
-        "Function passed too many arguments. Got %i, expected %i",
-        given,
-        total
-      );
-    }
+  /* a partial application passes the arguments it holds before a to its lambda */
+  if (f->fn) {
+    // joined in a buffer of their own, so the held buffer never gains the cells of a call
+    lval* held = lval_unshare(lval_copy(f->args));
+    lval_own_cells(held);
+    a = lval_unshare(lval_join(held, a));
+    f = f->fn;
+  }
 
-    lval* sym = lval_pop(f->formals, 0);
-    if (strcmp(sym->sym, "&") == 0) {
-      if (f->formals->count != 1) {
-        // ensure '&' is followed by another symbol
-        lval_del(a);
-        return lval_err("Function format invalid. Symbol '&' not followed by single symbol");
-      }
-
-      // bind all of the remaining arguments to the next formal
-      lval* nsym = lval_pop(f->formals, 0);
-      lenv_put(f->env, nsym, builtin_list(e, a));
-      lval_del(sym);
-      lval_del(nsym);
-      break;
-    }
-    lval* val = lval_pop(a, 0);
-    lenv_put(f->env, sym, val);
-    lval_del(sym);
-    lval_del(val);
+  /* formals after '&' take whatever arguments are left over */
+  lval** formals = f->formals->cell;
+  int fixed = f->fixed;
+  int variadic = fixed < f->formals->count;
+
+  if (a->count < fixed) {
+    // too few arguments, so hold on to them until the rest are given
+    lval* rest = lval_unshare(lval_copy(f->formals));
+    for (int i = 0; i < a->count; i++) { lval_del(lval_pop(rest, 0)); }
+    return lval_partial(f, builtin_list(e, a), rest);
   }
 
-  // argument list is now bound, so this can be cleaned up
-  lval_del(a);
+  if (variadic && f->formals->count - fixed != 2) {
+    // ensure '&' is followed by another symbol
+    lval_del(a);
+    return lval_err("Function format invalid. Symbol '&' not followed by single symbol");
+  }
 
-  if (f->formals->count > 0 && strcmp(f->formals->cell[0]->sym, "&") == 0) {
-    // if '&' remains in formals list
-    if (f->formals->count != 2) {
-      return lval_err("Function format invalid. Symbol '&' not followed by single symbol");
-    }
+  if (!variadic && a->count > fixed) {
+    lval_del(a);
+    return lval_err(
+      "Function passed too many arguments. Got %i, expected %i",
+      given,
+      total
+    );
+  }
 
-    lval_del(lval_pop(f->formals, 0)); // pop and delete '&' symbol
-    lval* sym = lval_pop(f->formals, 0);
-    lval* val = lval_qexpr();
-    lenv_put(f->env, sym, val);
-    lval_del(sym);
-    lval_del(val);
+  /* the table is sized up front, so binding never grows it */
+  lenv* frame = lenv_new();
+  lenv_reserve(frame, fixed + variadic);
+  for (int i = 0; i < fixed; i++) {
+    lenv_put(frame, formals[i], a->cell[i]);
   }
 
-  if (f->formals->count == 0) {
-    // if all formals have been evaluated, evaluate and return
-    f->env->par = e;
-    return builtin_eval(f->env, lval_add(lval_sexpr(), lval_copy(f->body)));
-  } else {
-    // otherwise return partially evaluated function
-    return lval_copy(f);
+  if (variadic) {
+    // bind all of the remaining arguments to the formal after '&'
+    for (int i = 0; i < fixed; i++) { lval_del(lval_pop(a, 0)); }
+    lenv_put(frame, formals[fixed + 1], builtin_list(e, a));
   }
+
+  // argument list is now bound, so this can be cleaned up
+  lval_del(a);
+
+  /* all formals are bound, the body is evaluated by the caller */
+  *env = frame;
+  return NULL;
 }
 
 lval* lval_eval_sexpr(lenv* e, lval* v);
+int lval_eval_call(lenv** e, lval** v, lframes* frames);
+
+lbuiltin lval_tail_target(lbuiltin f) {
+  /* builtins that finish by evaluating a Q-Expression are paired with */
+  /* a function returning that Q-Expression, so it can be a tail call */
+  if (f == builtin_if) { return builtin_if_branch; }
+  if (f == builtin_eval) { return builtin_eval_target; }
+  if (f == builtin_fst) { return builtin_fst_target; }
+  if (f == builtin_snd) { return builtin_snd_target; }
+  if (f == builtin_select) { return builtin_select_target; }
+  return NULL;
+}
 
 lval* lval_eval(lenv* e, lval* v) {
-  if (v->type == LVAL_SYM) {
+  if (lval_type(v) == LVAL_SYM) {
     lval* x = lenv_get(e, v);
     lval_del(v);
     return x;
   }
   /* evaluate S-Expressions */
-  if (v->type == LVAL_SEXPR) { return lval_eval_sexpr(e, v); }
+  if (lval_type(v) == LVAL_SEXPR) {
+    return vm_enabled ? vm_eval(e, v) : lval_eval_sexpr(e, v);
+  }
   /* all other lval types remain the same */
   return v;
 }
 
+lval* lval_eval_qexpr(lenv* e, lval* v) {
+  /* evaluate the cells of a Q-Expression as if it were an S-Expression */
+  return vm_enabled ? vm_eval(e, v) : lval_eval_sexpr(e, v);
+}
+
 lval* lval_eval_sexpr(lenv* e, lval* v) {
-  /* evaluate children */
-  for (int i = 0; i < v->count; i++) {
-    v->cell[i] = lval_eval(e, v->cell[i]);
+  /* v may also be a Q-Expression handed back by a tail call */
+  lframes frames = { 0, 0, NULL };
+
+  while (1) {
+    /* special forms evaluate only the cells they need */
+    lval* r;
+    int form = lval_eval_form(e, v, &r);
+    if (form != FORM_NONE) {
+      lval_del(v);
+      v = r;
+      if (form == FORM_DONE) { break; }
+      continue;
+    }
+
+    /* v is only read, so a function body is never copied for a call */
+    /* the results of its cells are written into a new S-Expression */
+    lval* x = lval_sexpr();
+    if (v->count) {
+      lval_reserve(x, NULL, v->count);
+      x->count = x->buf->used = v->count;
+    }
+
+    /* evaluate children */
+    for (int i = 0; i < v->count; i++) {
+      lval* c = v->cell[i];
+      x->cell[i] = lval_type(c) == LVAL_SYM ? lenv_get(e, c) : lval_eval(e, lval_copy(c));
+    }
+
+    lval_del(v);
+    v = x;
+    if (!lval_eval_call(&e, &v, &frames)) { break; }
   }
 
+  lframes_del(&frames);
+  return v;
+}
+
+lval* lval_apply(lenv* e, lval* v) {
+  /* call an S-Expression whose cells have already been evaluated */
+  lframes frames = { 0, 0, NULL };
+  if (lval_eval_call(&e, &v, &frames)) {
+    v = lval_eval_qexpr(e, v);
+  }
+  lframes_del(&frames);
+  return v;
+}
+
+int lval_eval_call(lenv** e, lval** v, lframes* frames) {
+  /* call the S-Expression *v whose cells have already been evaluated */
+  /* returns 0 with the result in *v, or 1 for a tail call of *v in *e */
+  lval* a = *v;
+
   /* error checking */
-  for (int i = 0; i < v->count; i++) {
-    if (v->cell[i]->type == LVAL_ERR) { return lval_take(v, i); }
+  for (int i = 0; i < a->count; i++) {
+    if (lval_type(a->cell[i]) == LVAL_ERR) {
+      *v = lval_take(a, i);
+      return 0;
+    }
   }
 
   /* empty expression */
-  if (v->count == 0) { return v; }
+  if (a->count == 0) { return 0; }
 
   /* single expression */
-  if (v->count == 1) { return lval_take(v, 0); }
+  if (a->count == 1) {
+    *v = lval_take(a, 0);
+    return 0;
+  }
 
   /* ensure first element is a function after evaluation */
-  lval* f = lval_pop(v, 0);
-  if (f->type != LVAL_FUN) {
-    lval* err = lval_err(
+  lval* f = lval_pop(a, 0);
+  if (lval_type(f) != LVAL_FUN) {
+    *v = lval_err(
       "S-Expression starts with incorrect type. Got %s, expected %s.",
-      ltype_name(f->type),
+      ltype_name(lval_type(f)),
       ltype_name(LVAL_FUN)
     );
-    lval_del(v);
+    lval_del(a);
     lval_del(f);
-    return err;
+    return 0;
   }
 
-  /* If so call the function to get the result */
-  lval* result = lval_call(e, f, v);
+  if (f->builtin) {
+    lbuiltin target = lval_tail_target(f->builtin);
+    if (target) {
+      *v = target(*e, a);
+      lval_del(f);
+      return lval_type(*v) != LVAL_ERR;
+    }
+
+    *v = f->builtin(*e, a);
+    lval_del(f);
+    return 0;
+  }
+
+  /* lambdas are left as they are, their arguments are bound in a new env */
+  lenv* env;
+  lval* result = lval_bind(*e, f, a, &env);
+  if (result) {
+    *v = result;
+    lval_del(f);
+    return 0;
+  }
+
+  /* continue with the body in the new environment */
+  *v = lval_copy(f->body);
   lval_del(f);
-  return result;
+
+  lframes_enter(frames, env, *e);
+  *e = env;
+  return 1;
 }
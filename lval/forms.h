@@ -0,0 +1,121 @@
+/*
+Special forms
+'if', 'select' (or 'cond'), 'and' and 'or' are builtins, but an S-Expression starting
+with one of their names, while it is still bound to that builtin, is run
+here instead of being called. Only the cells that are needed are
+evaluated, and the branch taken by 'if' or 'select' is continued with in
+tail position. Anything not in the shape of the form is called as usual.
+*/
+
+lval* lenv_get(lenv* e, lval* k);
+lval* lval_eval(lenv* e, lval* v);
+lval* builtin_if(lenv* e, lval* a);
+lval* builtin_if_branch(lenv* e, lval* a);
+lval* builtin_select(lenv* e, lval* a);
+lval* builtin_select_clause(lenv* e, lval* a, int from, lval** pick);
+lval* builtin_and(lenv* e, lval* a);
+lval* builtin_or(lenv* e, lval* a);
+
+/* results of lval_eval_form */
+enum { FORM_NONE, FORM_DONE, FORM_TAIL };
+
+int lval_is_form(lval* v) {
+  /* whether v starts with the name of a special form */
+  static char* names[5] = { NULL };
+  if (!names[0]) {
+    names[0] = sym_intern("if", sym_hash("if"));
+    names[1] = sym_intern("select", sym_hash("select"));
+    names[2] = sym_intern("and", sym_hash("and"));
+    names[3] = sym_intern("or", sym_hash("or"));
+    names[4] = sym_intern("cond", sym_hash("cond"));
+  }
+
+  if (!v->count || lval_type(v->cell[0]) != LVAL_SYM) { return 0; }
+  for (int i = 0; i < 5; i++) {
+    if (v->cell[0]->sym == names[i]) { return 1; }
+  }
+  return 0;
+}
+
+int lval_cells_are(lval* v, int from, int type, int min) {
+  /* whether the cells of v from index from on all have type and at least min cells */
+  for (int i = from; i < v->count; i++) {
+    if (lval_type(v->cell[i]) != type || v->cell[i]->count < min) { return 0; }
+  }
+  return 1;
+}
+
+lval* lval_form_logic(lenv* e, lval* v, char* func, int stop) {
+  /* evaluates the arguments of 'and' or 'or' until one has truth stop */
+  for (int i = 1; i < v->count; i++) {
+    lval* y = lval_eval(e, lval_copy(v->cell[i]));
+    if (lval_type(y) == LVAL_ERR) { return y; }
+    if (lval_type(y) != LVAL_NUM) {
+      lval* err = lval_err(
+        "Function '%s' passed incorrect type for argument %i. Got %s, expected %s.",
+        func,
+        i - 1,
+        ltype_name(lval_type(y)),
+        ltype_name(LVAL_NUM)
+      );
+      lval_del(y);
+      return err;
+    }
+
+    if (i == v->count - 1 || (lval_to_num(y) != 0) == stop) { return y; }
+    lval_del(y);
+  }
+  return NULL;
+}
+
+int lval_eval_form(lenv* e, lval* v, lval** r) {
+  /* evaluates v if it is a special form, giving FORM_DONE with the result in *r */
+  /* or FORM_TAIL with the expression to continue with, otherwise FORM_NONE */
+  if (!lval_is_form(v)) { return FORM_NONE; }
+
+  lval* f = lenv_get(e, v->cell[0]);
+  lbuiltin b = lval_type(f) == LVAL_FUN ? f->builtin : NULL;
+  lval_del(f);
+
+  if (b == builtin_if && v->count == 4 && lval_cells_are(v, 2, LVAL_QEXPR, 0)) {
+    lval* c = lval_eval(e, lval_copy(v->cell[1]));
+    if (lval_type(c) == LVAL_ERR) {
+      *r = c;
+      return FORM_DONE;
+    }
+    if (lval_type(c) != LVAL_NUM) {
+      // let the builtin report the error, as a call would
+      lval* a = lval_add(lval_sexpr(), c);
+      a = lval_add(a, lval_copy(v->cell[2]));
+      a = lval_add(a, lval_copy(v->cell[3]));
+      *r = builtin_if_branch(e, a);
+      return FORM_DONE;
+    }
+
+    *r = lval_copy(v->cell[lval_to_num(c) ? 2 : 3]);
+    lval_del(c);
+    return FORM_TAIL;
+  }
+
+  if (b == builtin_select && v->count > 1 && lval_cells_are(v, 1, LVAL_QEXPR, 2)) {
+    lval* pick;
+    lval* err = builtin_select_clause(e, v, 1, &pick);
+    if (err) {
+      *r = err;
+      return FORM_DONE;
+    }
+    if (lval_type(pick) == LVAL_SEXPR) {
+      *r = lval_copy(pick);
+      return FORM_TAIL;
+    }
+    *r = lval_eval(e, lval_copy(pick));
+    return FORM_DONE;
+  }
+
+  if ((b == builtin_and || b == builtin_or) && v->count > 1) {
+    *r = lval_form_logic(e, v, b == builtin_and ? "and" : "or", b == builtin_or);
+    return FORM_DONE;
+  }
+
+  return FORM_NONE;
+}
@@ -0,0 +1,71 @@
+/*
+Global table of interned symbol names
+Every distinct name is stored exactly once and never freed, so two symbols
+are the same exactly when their sym pointers are equal
+Each name is stored after a count of the env bindings it has, so lookups
+can tell when the outermost binding of a symbol is the only one
+*/
+
+typedef struct {
+  int binds;
+  char name[];
+} sym_info;
+
+sym_info* sym_info_of(char* sym) {
+  return (sym_info*)(sym - offsetof(sym_info, name));
+}
+
+struct {
+  int count;
+  int capacity;
+  char** names;
+  unsigned long* hashes;
+} sym_table = { 0, 0, NULL, NULL };
+
+int sym_table_find(char* s, unsigned long hash) {
+  /* returns the slot holding s, or the empty slot where it belongs */
+  int mask = sym_table.capacity - 1;
+  int i = hash & mask;
+  while (sym_table.names[i]) {
+    if (sym_table.hashes[i] == hash && strcmp(sym_table.names[i], s) == 0) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+void sym_table_grow(void) {
+  int old_capacity = sym_table.capacity;
+  char** old_names = sym_table.names;
+  unsigned long* old_hashes = sym_table.hashes;
+
+  sym_table.capacity = old_capacity ? old_capacity * 2 : 256;
+  sym_table.names = calloc(sym_table.capacity, sizeof(char*));
+  sym_table.hashes = calloc(sym_table.capacity, sizeof(unsigned long));
+  for (int i = 0; i < old_capacity; i++) {
+    if (old_names[i]) {
+      int j = sym_table_find(old_names[i], old_hashes[i]);
+      sym_table.names[j] = old_names[i];
+      sym_table.hashes[j] = old_hashes[i];
+    }
+  }
+  free(old_names);
+  free(old_hashes);
+}
+
+char* sym_intern(char* s, unsigned long hash) {
+  /* keep the table at most half full */
+  if ((sym_table.count + 1) * 2 > sym_table.capacity) { sym_table_grow(); }
+
+  int i = sym_table_find(s, hash);
+  if (!sym_table.names[i]) {
+    sym_info* info = malloc(sizeof(sym_info) + strlen(s) + 1);
+    info->binds = 0;
+    strcpy(info->name, s);
+    sym_table.names[i] = info->name;
+    sym_table.hashes[i] = hash;
+    sym_table.count++;
+  }
+  return sym_table.names[i];
+}
@@ -2,66 +2,36 @@
 Main value object used throughout leesp
 Includes functions to create and use lval instances
 requires useage of an environment
+Values are reference counted rather than traced, as none can form a cycle.
+Lambdas hold no environment, an expression is only changed in place while
+nothing else references it, and a shared cell buffer only takes cells that
+cannot reach it, see cells.h
 */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
 
 #include "base.h"
+#include "intern.h"
 #include "constructors.h"
+#include "cells.h"
 #include "edit.h"
 #include "print.h"
+#include "forms.h"
 #include "evaluation.h"
 
-lval* lval_read_num(mpc_ast_t* t) {
-  errno = 0;
-  long x = strtol(t->contents, NULL, 10);
-  return errno != ERANGE ? lval_num(x) : lval_err("invalid number");
-}
-
-lval* lval_read_str(mpc_ast_t* t) {
-  t->contents[strlen(t->contents) - 1] = '\0'; // cut off final quote char
-  char* unescaped = malloc(strlen(t->contents + 1) + 1);
-  strcpy(unescaped, t->contents + 1);
-  unescaped = mpcf_unescape(unescaped);
-  lval* str = lval_str(unescaped);
-  free(unescaped);
-  return str;
-}
-
-lval* lval_read(mpc_ast_t* t) {
-  /* if symbol, number, or string return the conversion to that type */
-  if (strstr(t->tag, "number")) { return lval_read_num(t); }
-  if (strstr(t->tag, "symbol")) { return lval_sym(t->contents); }
-  if (strstr(t->tag, "string")) { return lval_read_str(t); }
-
-  /* if root (>) or sexpr or qexpr then create an empty list */
-  lval* x = NULL;
-  if (strcmp(t->tag, ">") == 0) { x = lval_sexpr(); }
-  if (strstr(t->tag, "sexpr")) { x = lval_sexpr(); }
-  if (strstr(t->tag, "qexpr")) { x = lval_qexpr(); }
-
-  /* fill this list with any valid expression contained within */
-  for (int i = 0; i < t->children_num; i++) {
-    if (strcmp(t->children[i]->contents, "(") == 0) { continue; }
-    if (strcmp(t->children[i]->contents, ")") == 0) { continue; }
-    if (strcmp(t->children[i]->contents, "{") == 0) { continue; }
-    if (strcmp(t->children[i]->contents, "}") == 0) { continue; }
-    if (strcmp(t->children[i]->tag, "regex") == 0) { continue; }
-    if (strstr(t->children[i]->tag, "comment")) { continue; }
-    x = lval_add(x, lval_read(t->children[i]));
-  }
-
-  return x;
-}
-
 int lvals_are_equal(lval* x, lval* y) {
-  if (x->type != y->type) { return 0; }
+  /* shared lvals are trivially equal */
+  if (x == y) { return 1; }
+  if (lval_type(x) != lval_type(y)) { return 0; }
 
-  switch (x->type) {
-    case LVAL_NUM: return (x->num == y->num);
+  switch (lval_type(x)) {
+    case LVAL_NUM: return (lval_to_num(x) == lval_to_num(y));
     case LVAL_ERR: return (strcmp(x->err, y->err) == 0);
-    case LVAL_SYM: return (strcmp(x->sym, y->sym) == 0);
+    case LVAL_SYM: return (x->sym == y->sym);
     case LVAL_STR: return (strcmp(x->str, y->str) == 0);
     case LVAL_FUN:
       if (x->builtin || y->builtin) {
@@ -21,8 +21,8 @@ void lval_expr_print(lval* v, char open, char close) {
 }
 
 void lval_print(lval* v) {
-  switch (v->type) {
-    case LVAL_NUM: printf("%li", v->num); break;
+  switch (lval_type(v)) {
+    case LVAL_NUM: printf("%li", lval_to_num(v)); break;
     case LVAL_ERR: printf("Error: %s", v->err); break;
     case LVAL_SYM: printf("%s", v->sym); break;
     case LVAL_STR: lval_print_str(v); break;
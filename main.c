@@ -3,20 +3,13 @@
 
 #include "include/mpc/mpc.h"
 
-/* parser foward declarations */
-mpc_parser_t* Number;
-mpc_parser_t* Symbol;
-mpc_parser_t* String;
-mpc_parser_t* Comment;
-mpc_parser_t* Sexpr;
-mpc_parser_t* Qexpr;
-mpc_parser_t* Expr;
-mpc_parser_t* Leesp;
-
 #include "shared/structs.h"
+#include "pool/pool.h"
 #include "lval/lval.h"
 #include "lenv/lenv.h"
+#include "reader/reader.h"
 #include "builtin_functions/builtin.h"
+#include "vm/vm.h"
 
 // compile if compiling on windows
 #ifdef _WIN32
@@ -37,6 +30,9 @@ mpc_parser_t* Leesp;
   // fake the add_history function
   void add_history(char* unused) {}
 
+  #include <io.h>
+  int stdin_is_terminal(void) { return _isatty(_fileno(stdin)); }
+
 // otherwise include the editline headers
 #elif __APPLE__
   #include <editline/readline.h>
@@ -46,6 +42,10 @@ mpc_parser_t* Leesp;
   #include <editline/history.h>
 #endif
 
+#ifndef _WIN32
+  int stdin_is_terminal(void) { return isatty(STDIN_FILENO); }
+#endif
+
 void lenv_add_builtin(lenv* e, char* name, lbuiltin func) {
   lval* k = lval_sym(name);
   lval* v = lval_fun(func);
@@ -61,6 +61,14 @@ void lenv_add_builtins(lenv* e) {
   lenv_add_builtin(e, "tail", builtin_tail);
   lenv_add_builtin(e, "eval", builtin_eval);
   lenv_add_builtin(e, "join", builtin_join);
+  lenv_add_builtin(e, "len", builtin_len);
+  lenv_add_builtin(e, "fst", builtin_fst);
+  lenv_add_builtin(e, "snd", builtin_snd);
+  lenv_add_builtin(e, "map", builtin_map);
+  lenv_add_builtin(e, "filter", builtin_filter);
+  lenv_add_builtin(e, "foldl", builtin_foldl);
+  lenv_add_builtin(e, "sum", builtin_sum);
+  lenv_add_builtin(e, "product", builtin_product);
   lenv_add_builtin(e, "def", builtin_def);
   lenv_add_builtin(e, "=", builtin_put);
 
@@ -81,52 +89,66 @@ void lenv_add_builtins(lenv* e) {
   lenv_add_builtin(e, "!=", builtin_not_equal);
 
   lenv_add_builtin(e, "\\", builtin_lambda);
+
+  /* logical functions */
   lenv_add_builtin(e, "if", builtin_if);
+  lenv_add_builtin(e, "select", builtin_select);
+  lenv_add_builtin(e, "cond", builtin_select);
+  lenv_add_builtin(e, "and", builtin_and);
+  lenv_add_builtin(e, "or", builtin_or);
 
   /* string functions */
   lenv_add_builtin(e, "load", builtin_load);
   lenv_add_builtin(e, "error", builtin_error);
   lenv_add_builtin(e, "print", builtin_print);
+
+  /* memory functions */
+  lenv_add_builtin(e, "pool-stats", builtin_pool_stats);
 }
 
-void load_standard_library(lenv* e) {
-  lval* args = lval_add(lval_sexpr(), lval_str("./library/standard.leesp"));
+void load_library(lenv* e, char* path) {
+  lval* args = lval_add(lval_sexpr(), lval_str(path));
   lval* result = builtin_load(e, args);
-  if (result->type == LVAL_ERR) { lval_print_ln(result); }
+  if (lval_type(result) == LVAL_ERR) { lval_print_ln(result); }
   lval_del(result);
 }
 
+void load_standard_library(lenv* e, int reference_lists) {
+  load_library(e, "./library/standard.leesp");
+
+  /* replace the builtin list functions with their Leesp definitions */
+  if (reference_lists) { load_library(e, "./library/lists.leesp"); }
+}
+
 int main(int argc, char** argv) {
-  /* create some parsers */
-  Number = mpc_new("number");
-  Symbol = mpc_new("symbol");
-  String = mpc_new("string");
-  Comment = mpc_new("comment");
-  Sexpr = mpc_new("sexpr");
-  Qexpr = mpc_new("qexpr");
-  Expr = mpc_new("expr");
-  Leesp = mpc_new("leesp");
-
-  /* define them with the following language */
-  mpca_lang(MPCA_LANG_DEFAULT,
-    " \
-      number: /-?[0-9]+/ ; \
-      symbol: /[a-zA-Z0-9_+\\-*\\/\\\\=<>!&]+/ ; \
-      string: /\"(\\\\.|[^\"])*\"/ ; \
-      comment: /;[^\\r\\n]*/ ; \
-      sexpr: '(' <expr>* ')' ; \
-      qexpr: '{' <expr>* '}' ; \
-      expr: <number> | <symbol> | <string> | <comment> | <sexpr> | <qexpr> ; \
-      leesp: /^/ <expr>* /$/ ; \
-    ",
-    Number, Symbol, String, Comment, Sexpr, Qexpr, Expr, Leesp
-  );
+  /* flags must be known before the standard library is loaded */
+  int files = 0;
+  int reference_lists = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--vm") == 0) {
+      vm_enabled = 1;
+    } else if (strcmp(argv[i], "--reference-lists") == 0) {
+      reference_lists = 1;
+    } else if (strncmp(argv[i], "--", 2) == 0) {
+      fprintf(stderr, "Unknown option %s\n", argv[i]);
+      return 1;
+    } else {
+      files++;
+    }
+  }
 
   lenv* e = lenv_new();
   lenv_add_builtins(e);
-  load_standard_library(e);
-
-  if (argc == 1) {
+  load_standard_library(e, reference_lists);
+
+  if (files == 0 && !stdin_is_terminal()) {
+    /* a program piped in is run like a script */
+    lreader r;
+    lreader_open(&r, "<stdin>", stdin);
+    lval* result = builtin_load_reader(e, &r);
+    if (lval_type(result) == LVAL_ERR) { lval_print_ln(result); }
+    lval_del(result);
+  } else if (files == 0) {
     puts("Leesp version 1.0.0");
     puts("Press ctrl+c to exit\n");
 
@@ -134,37 +156,34 @@ int main(int argc, char** argv) {
       char* input = readline("leesp> ");
       add_history(input);
 
-      /* attempt to parse the user input */
-      mpc_result_t r;
-      // mpc_parse returns 1 on success and 0 on failure
-      if (mpc_parse("<stdin>", input, Leesp, &r)) {
-        lval* x = lval_eval(e, lval_read(r.output));
+      /* attempt to read the user input */
+      lreader r;
+      lreader_init(&r, "<stdin>", input, strlen(input));
+      lval* x = lreader_all(&r);
+      if (x) {
+        x = lval_eval(e, x);
         lval_print_ln(x);
         lval_del(x);
-
-        mpc_ast_delete(r.output);
       } else {
         /* otherwise print the error */
-        mpc_err_print(r.error);
-        mpc_err_delete(r.error);
+        fputs(r.err, stdout);
       }
 
+      lreader_free(&r);
       free(input);
     }
   } else {
     for (int i = 1; i < argc; i++) {
       // i = 1 because first argument is always the program
+      if (strcmp(argv[i], "--vm") == 0 || strcmp(argv[i], "--reference-lists") == 0) { continue; }
       lval* args = lval_add(lval_sexpr(), lval_str(argv[i]));
       lval* result = builtin_load(e, args);
-      if (result->type == LVAL_ERR) { lval_print_ln(result); }
+      if (lval_type(result) == LVAL_ERR) { lval_print_ln(result); }
       lval_del(result);
     }
   }
 
   lenv_del(e);
 
-  /* undefine and delete our parsers */
-  mpc_cleanup(8, Number, Symbol, String, Comment, Sexpr, Qexpr, Expr, Leesp);
-
   return 0;
 }
@@ -0,0 +1,78 @@
+/*
+Size class pool allocator for lval and lenv nodes, in steps of 8 bytes
+Each size class carves page sized slabs into equal blocks and keeps freed
+blocks on a free list, so constructing and deleting nodes never reaches
+malloc once the pool is warm. Slabs are kept for the life of the program.
+Build with -DLEESP_NO_POOL to use plain malloc, e.g. for sanitizer builds.
+*/
+
+#define POOL_SLAB_SIZE 4096
+#define POOL_GRANULE 8
+#define POOL_CLASSES 16
+
+#if __STDC_VERSION__ >= 201112L
+  #define POOL_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+  #define POOL_THREAD_LOCAL __thread
+#else
+  #define POOL_THREAD_LOCAL
+#endif
+
+typedef struct pool_block {
+  struct pool_block* next;
+} pool_block;
+
+typedef struct {
+  pool_block* free;
+  long slabs;
+  long in_use;
+} pool_class;
+
+POOL_THREAD_LOCAL pool_class pool[POOL_CLASSES];
+
+int pool_class_of(size_t size) {
+  /* round up to the next granule, -1 if too large for any class */
+  int c = (size + POOL_GRANULE - 1) / POOL_GRANULE - 1;
+  return c < POOL_CLASSES ? c : -1;
+}
+
+void pool_refill(int c) {
+  /* carve a new slab into blocks and push them all onto the free list */
+  size_t size = (c + 1) * POOL_GRANULE;
+  char* slab = malloc(POOL_SLAB_SIZE);
+  for (size_t i = 0; i + size <= POOL_SLAB_SIZE; i += size) {
+    pool_block* b = (pool_block*)(slab + i);
+    b->next = pool[c].free;
+    pool[c].free = b;
+  }
+  pool[c].slabs++;
+}
+
+void* pool_alloc(size_t size) {
+#ifdef LEESP_NO_POOL
+  return malloc(size);
+#else
+  int c = pool_class_of(size);
+  if (c < 0) { return malloc(size); }
+
+  if (!pool[c].free) { pool_refill(c); }
+  pool_block* b = pool[c].free;
+  pool[c].free = b->next;
+  pool[c].in_use++;
+  return b;
+#endif
+}
+
+void pool_free(void* p, size_t size) {
+#ifdef LEESP_NO_POOL
+  free(p);
+#else
+  int c = pool_class_of(size);
+  if (c < 0) { free(p); return; }
+
+  pool_block* b = p;
+  b->next = pool[c].free;
+  pool[c].free = b;
+  pool[c].in_use--;
+#endif
+}
@@ -0,0 +1,376 @@
+/*
+Reader turning Leesp source text into lvals
+A single pass over the bytes, with the tokens
+  number   -?[0-9]+
+  symbol   one or more letters, digits or any of _ + - * / \ = < > ! &
+  string   "(\\.|[^"])*"
+  comment  ;[^\r\n]*
+separated by any whitespace, and expressions nested in () and {}.
+A number is taken before a symbol, so "5abc" reads as 5 followed by abc.
+Syntax errors report the row and column of the first unexpected character.
+A stream is read a block at a time and only the bytes not yet read past
+are kept, so a file can be read one top level expression at a time.
+Regular files are mapped instead where mmap is available, and read in place.
+*/
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#define LREADER_SPACE_CHARS " \f\n\r\t\v"
+#define LREADER_SYMBOL_CHARS \
+  "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_+-*/\\=<>!&"
+
+/* what each byte can start, digits and '-' are also symbol bytes */
+enum {
+  LREADER_OTHER,
+  LREADER_SPACE,
+  LREADER_COMMENT,
+  LREADER_STRING,
+  LREADER_SEXPR,
+  LREADER_QEXPR,
+  LREADER_DIGIT,
+  LREADER_MINUS,
+  LREADER_SYMBOL
+};
+
+unsigned char lreader_class[256];
+
+void lreader_classes(void) {
+  /* fill in lreader_class the first time a reader is made */
+  if (lreader_class['(']) { return; }
+  for (char* c = LREADER_SYMBOL_CHARS; *c; c++) { lreader_class[(unsigned char)*c] = LREADER_SYMBOL; }
+  for (char* c = LREADER_SPACE_CHARS; *c; c++) { lreader_class[(unsigned char)*c] = LREADER_SPACE; }
+  for (char c = '0'; c <= '9'; c++) { lreader_class[(unsigned char)c] = LREADER_DIGIT; }
+  lreader_class['-'] = LREADER_MINUS;
+  lreader_class[';'] = LREADER_COMMENT;
+  lreader_class['"'] = LREADER_STRING;
+  lreader_class['('] = LREADER_SEXPR;
+  lreader_class['{'] = LREADER_QEXPR;
+}
+
+/* bytes read from a stream at a time */
+#define LREADER_BLOCK 65536
+
+typedef struct {
+  char* name; /* shown in syntax errors */
+  FILE* in;   /* where more source is read from, if anywhere */
+  int mapped; /* whether s is a mapping of the whole file */
+
+  /* the source, or the part of the stream not yet read past */
+  char* s;
+  long len;
+  long pos;
+  long capacity;
+
+  /* row and column of the first byte of s */
+  int row;
+  int col;
+
+  /* the current token, copied out so it can be terminated */
+  char* tok;
+  long tok_capacity;
+
+  /* set once a syntax error is found */
+  char* err;
+} lreader;
+
+void lreader_init(lreader* r, char* name, char* s, long len) {
+  /* read from the len bytes at s */
+  r->name = name;
+  r->in = NULL;
+  r->mapped = 0;
+  r->s = s;
+  r->len = len;
+  r->pos = 0;
+  r->capacity = len;
+  r->row = 1;
+  r->col = 1;
+  r->tok = NULL;
+  r->tok_capacity = 0;
+  r->err = NULL;
+  lreader_classes();
+}
+
+void lreader_open(lreader* r, char* name, FILE* in) {
+  /* read from in a block at a time, only keeping what has not been read past */
+  lreader_init(r, name, malloc(LREADER_BLOCK), 0);
+  r->in = in;
+  r->capacity = LREADER_BLOCK;
+}
+
+int lreader_map(lreader* r, char* path) {
+  /* read from a read only mapping of the file at path */
+  /* returns 0 if it is not a regular file that can be mapped */
+#ifdef _WIN32
+  return 0;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) { return 0; }
+
+  struct stat st;
+  char* s = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    s = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (s == MAP_FAILED) { return 0; }
+
+  lreader_init(r, path, s, st.st_size);
+  r->mapped = 1;
+  return 1;
+#endif
+}
+
+void lreader_free(lreader* r) {
+#ifndef _WIN32
+  if (r->mapped) { munmap(r->s, r->len); }
+#endif
+  if (r->in) { free(r->s); }
+  free(r->tok);
+  free(r->err);
+}
+
+void lreader_rows(lreader* r, long end, int* row, int* col) {
+  /* the row and column of the byte at end */
+  *row = r->row;
+  *col = r->col;
+  for (long i = 0; i < end; i++) {
+    if (r->s[i] == '\n') {
+      (*row)++;
+      *col = 1;
+    } else {
+      (*col)++;
+    }
+  }
+}
+
+int lreader_fill(lreader* r, long n) {
+  /* read until the byte n past the current position is in s */
+  /* returns 0 if the input ends first */
+  if (!r->in) { return 0; }
+
+  while (r->pos + n >= r->len) {
+    // drop what has been read past, keeping the token in progress
+    if (r->pos) {
+      lreader_rows(r, r->pos, &r->row, &r->col);
+      memmove(r->s, r->s + r->pos, r->len - r->pos);
+      r->len -= r->pos;
+      r->pos = 0;
+    }
+
+    // only a token longer than the buffer makes it grow
+    if (r->len == r->capacity) {
+      r->capacity *= 2;
+      r->s = realloc(r->s, r->capacity);
+    }
+
+    size_t read = fread(r->s + r->len, 1, r->capacity - r->len, r->in);
+    if (read == 0) { return 0; }
+    r->len += read;
+  }
+  return 1;
+}
+
+int lreader_at(lreader* r, long n) {
+  /* the byte n past the current position, or EOF */
+  if (r->pos + n >= r->len && !lreader_fill(r, n)) { return EOF; }
+  return (unsigned char)r->s[r->pos + n];
+}
+
+int lreader_skip(lreader* r) {
+  /* skip whitespace and comments, returning the next byte or EOF */
+  int c;
+  while ((c = lreader_at(r, 0)) != EOF) {
+    switch (lreader_class[c]) {
+      case LREADER_SPACE:
+        r->pos++;
+        break;
+
+      case LREADER_COMMENT:
+        while ((c = lreader_at(r, 0)) != EOF && c != '\n' && c != '\r') { r->pos++; }
+        break;
+
+      default:
+        return c;
+    }
+  }
+  return EOF;
+}
+
+void lreader_error(lreader* r, char* expected) {
+  /* record a syntax error at the current position */
+  int row, col;
+  lreader_rows(r, r->pos, &row, &col);
+
+  char found[16];
+  int c = lreader_at(r, 0);
+  if (c != EOF) {
+    snprintf(found, sizeof(found), "'%c'", c);
+  } else {
+    strcpy(found, "end of input");
+  }
+
+  int size = snprintf(NULL, 0, "%s:%i:%i: error: expected %s at %s\n", r->name, row, col, expected, found);
+  r->err = malloc(size + 1);
+  snprintf(r->err, size + 1, "%s:%i:%i: error: expected %s at %s\n", r->name, row, col, expected, found);
+}
+
+char* lreader_token(lreader* r, long start, long n) {
+  /* copy the n bytes from start past the current position into the token buffer */
+  if (n + 1 > r->tok_capacity) {
+    r->tok_capacity = n + 1;
+    r->tok = realloc(r->tok, r->tok_capacity);
+  }
+  memcpy(r->tok, r->s + r->pos + start, n);
+  r->tok[n] = '\0';
+  return r->tok;
+}
+
+void lreader_unescape(char* s) {
+  /* replace escape sequences in place, leaving unknown ones as they are */
+  char* out = s;
+  while (*s) {
+    if (s[0] == '\\' && s[1]) {
+      char c = 0;
+      switch (s[1]) {
+        case 'a': c = '\a'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case 't': c = '\t'; break;
+        case 'v': c = '\v'; break;
+        case '\\': c = '\\'; break;
+        case '\'': c = '\''; break;
+        case '\"': c = '\"'; break;
+      }
+      if (c) {
+        *out++ = c;
+        s += 2;
+        continue;
+      }
+      // a NUL cannot be held in a string, so "\0" is dropped
+      if (s[1] == '0') {
+        s += 2;
+        continue;
+      }
+    }
+    *out++ = *s++;
+  }
+  *out = '\0';
+}
+
+int lreader_starts_expr(int c) {
+  return c != EOF && lreader_class[c] >= LREADER_STRING;
+}
+
+lval* lreader_expr(lreader* r);
+
+lval* lreader_list(lreader* r, lval* x, char close) {
+  /* read expressions up to the closing bracket */
+  char expected[] = "expression or ' '";
+  expected[strlen(expected) - 2] = close;
+
+  r->pos++;
+  while (1) {
+    int c = lreader_skip(r);
+    if (c == close) {
+      r->pos++;
+      return x;
+    }
+    if (!lreader_starts_expr(c)) {
+      lreader_error(r, expected);
+      lval_del(x);
+      return NULL;
+    }
+
+    lval* y = lreader_expr(r);
+    if (!y) {
+      lval_del(x);
+      return NULL;
+    }
+    x = lval_add(x, y);
+  }
+}
+
+lval* lreader_str(lreader* r) {
+  int c;
+  long n = 1;
+  while ((c = lreader_at(r, n)) != EOF && c != '"') {
+    // an escaped character never ends the string
+    if (c == '\\' && lreader_at(r, n + 1) != EOF) { n++; }
+    n++;
+  }
+
+  if (c == EOF) {
+    r->pos += n;
+    lreader_error(r, "'\"'");
+    return NULL;
+  }
+
+  char* s = lreader_token(r, 1, n - 1);
+  lreader_unescape(s);
+  r->pos += n + 1;
+  return lval_str(s);
+}
+
+lval* lreader_expr(lreader* r) {
+  /* read the expression starting at the current position */
+  long n = 0;
+
+  switch (lreader_class[lreader_at(r, 0)]) {
+    case LREADER_SEXPR: return lreader_list(r, lval_sexpr(), ')');
+    case LREADER_QEXPR: return lreader_list(r, lval_qexpr(), '}');
+    case LREADER_STRING: return lreader_str(r);
+
+    /* numbers are tried first, and end at the last digit */
+    case LREADER_MINUS:
+      if (lreader_at(r, 1) == EOF || lreader_class[lreader_at(r, 1)] != LREADER_DIGIT) { break; }
+      n++;
+      // fall through
+    case LREADER_DIGIT: {
+      int c;
+      while ((c = lreader_at(r, n)) != EOF && lreader_class[c] == LREADER_DIGIT) { n++; }
+
+      errno = 0;
+      long x = strtol(lreader_token(r, 0, n), NULL, 10);
+      r->pos += n;
+      return errno != ERANGE ? lval_num(x) : lval_err("invalid number");
+    }
+  }
+
+  int c;
+  while ((c = lreader_at(r, n)) != EOF && lreader_class[c] >= LREADER_DIGIT) { n++; }
+  lval* x = lval_sym(lreader_token(r, 0, n));
+  r->pos += n;
+  return x;
+}
+
+lval* lreader_form(lreader* r) {
+  /* read the next top level expression */
+  /* returns NULL at the end of input, or on a syntax error with r->err set */
+  int c = lreader_skip(r);
+  if (c == EOF) { return NULL; }
+  if (!lreader_starts_expr(c)) {
+    lreader_error(r, "expression or end of input");
+    return NULL;
+  }
+  return lreader_expr(r);
+}
+
+lval* lreader_all(lreader* r) {
+  /* read every top level expression into an S-Expression, or NULL on a syntax error */
+  lval* x = lval_sexpr();
+  lval* y;
+  while ((y = lreader_form(r))) { x = lval_add(x, y); }
+
+  if (r->err) {
+    lval_del(x);
+    return NULL;
+  }
+  return x;
+}
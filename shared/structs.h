@@ -2,31 +2,87 @@ struct lval;
 typedef struct lval lval;
 struct lenv;
 typedef struct lenv lenv;
+struct chunk;
+typedef struct chunk chunk;
+struct lcells;
+typedef struct lcells lcells;
 typedef lval*(*lbuiltin)(lenv*, lval*);
 
+/* open addressing hash table, an entry with a NULL sym is empty */
+typedef struct {
+  char* sym;
+  unsigned long hash;
+  lval* val;
+} lenv_entry;
+
 struct lenv {
   lenv* par;
+  lenv* top;
   int count;
-  char** syms;
-  lval** vals;
+  int capacity;
+  lenv_entry* entries;
 };
 
+/* tagged union, only the payload matching type is allocated, see lval_size */
 struct lval {
   int type;
+  int ref;
 
-  /* basic */
-  long num;
-  char* err;
-  char* sym;
-  char* str;
+  union {
+    /* basic */
+    long num;
+    char* err;
+    char* str;
+    struct {
+      char* sym;
+      unsigned long hash;
+      /* where lval_resolve expects to find the symbol bound */
+      int addr;
+      int slot;
+    };
 
-  /* function */
-  lbuiltin builtin;
-  lenv* env;
-  lval* formals;
-  lval* body;
+    /* function */
+    /* a partial application also holds the lambda it applies and */
+    /* the arguments given so far, and formals are those still unbound */
+    struct {
+      lbuiltin builtin;
+      lval* formals;
+      lval* body;
+      lval* fn;
+      lval* args;
+      int fixed; /* formals before any '&' */
+    };
+
+    /* expression */
+    /* cell points at the first of count cells inside buf */
+    struct {
+      int count;
+      lcells* buf;
+      lval** cell;
+      chunk* code;
+    };
+  };
+};
 
-  /* expression */
+struct lcells {
+  int refs;
+  int first;
+  int used;
+  int capacity;
+  lval* cells[];
+};
+
+struct chunk {
+  int refs;
+  int stack_size;
+
+  /* instructions are an opcode followed by a single operand */
   int count;
-  lval** cell;
+  int capacity;
+  int* code;
+
+  /* constants and symbols referenced by the instructions */
+  int const_count;
+  int const_capacity;
+  lval** consts;
 };
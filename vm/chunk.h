@@ -0,0 +1,65 @@
+/* enum of vm opcodes, each is followed by a single operand */
+enum {
+  OP_CONST,  /* push a copy of constant n */
+  OP_LOOKUP, /* push the value bound to symbol constant n */
+  OP_EXPR,   /* pop n values and evaluate them as an S-Expression */
+  OP_FORM,   /* evaluate constant n as a special form, skipping the next instruction if it is not one */
+  OP_JUMP    /* skip the next n instructions' worth of code */
+};
+
+chunk* chunk_new(void) {
+  chunk* c = malloc(sizeof(chunk));
+  c->refs = 1;
+  c->stack_size = 0;
+  c->count = 0;
+  c->capacity = 0;
+  c->code = NULL;
+  c->const_count = 0;
+  c->const_capacity = 0;
+  c->consts = NULL;
+  return c;
+}
+
+chunk* chunk_retain(chunk* c) {
+  c->refs++;
+  return c;
+}
+
+void chunk_release(chunk* c) {
+  /* chunks are shared between copies of the lval they are attached to */
+  if (--c->refs > 0) { return; }
+
+  for (int i = 0; i < c->const_count; i++) {
+    lval_del(c->consts[i]);
+  }
+  free(c->consts);
+  free(c->code);
+  free(c);
+}
+
+void chunk_emit(chunk* c, int op, int operand) {
+  if (c->count + 2 > c->capacity) {
+    c->capacity = c->capacity ? c->capacity * 2 : 16;
+    c->code = realloc(c->code, sizeof(int) * c->capacity);
+  }
+  c->code[c->count++] = op;
+  c->code[c->count++] = operand;
+}
+
+int chunk_add_const(chunk* c, lval* v) {
+  /* takes ownership of v and returns its constant index */
+  if (c->const_count == c->const_capacity) {
+    c->const_capacity = c->const_capacity ? c->const_capacity * 2 : 8;
+    c->consts = realloc(c->consts, sizeof(lval*) * c->const_capacity);
+  }
+  c->consts[c->const_count] = v;
+  return c->const_count++;
+}
+
+void chunk_trim(chunk* c) {
+  /* chunks live as long as their expression, so drop the room left to grow */
+  c->capacity = c->count;
+  c->code = realloc(c->code, sizeof(int) * c->capacity);
+  c->const_capacity = c->const_count;
+  c->consts = realloc(c->consts, sizeof(lval*) * (c->const_capacity ? c->const_capacity : 1));
+}
@@ -0,0 +1,78 @@
+chunk* vm_compile(lval* v);
+void vm_compile_expr(chunk* c, lval* v, int depth);
+
+void vm_compile_cells(lval* v) {
+  /* compile the S-Expressions among the cells of v ahead of time, for */
+  /* special forms that evaluate them one at a time */
+  for (int i = 0; i < v->count; i++) {
+    lval* x = v->cell[i];
+    if (lval_type(x) == LVAL_SEXPR && !x->code) { x->code = vm_compile(x); }
+  }
+}
+
+void vm_compile_sexpr(chunk* c, lval* v, int depth) {
+  /* compile the cells of v and the call of them */
+  /* a special form is tried first, and jumped over the call unless it falls back */
+  int jump = -1;
+  if (lval_is_form(v)) {
+    // a new S-Expression, so a body never holds a chunk that holds the body
+    lval* form = lval_sexpr();
+    for (int i = 0; i < v->count; i++) {
+      lval* x = v->cell[i];
+      if (lval_type(x) == LVAL_QEXPR) {
+        if (!x->code) { x->code = vm_compile(x); }
+        vm_compile_cells(x);
+      }
+      form = lval_add(form, lval_copy(x));
+    }
+    vm_compile_cells(form);
+
+    chunk_emit(c, OP_FORM, chunk_add_const(c, form));
+    jump = c->count;
+    chunk_emit(c, OP_JUMP, 0);
+  }
+
+  for (int i = 0; i < v->count; i++) {
+    vm_compile_expr(c, v->cell[i], depth + i);
+  }
+  chunk_emit(c, OP_EXPR, v->count);
+
+  if (jump >= 0) { c->code[jump + 1] = c->count - jump - 2; }
+}
+
+void vm_compile_expr(chunk* c, lval* v, int depth) {
+  /* depth is the number of values already on the stack when v is pushed */
+  if (depth + 1 > c->stack_size) { c->stack_size = depth + 1; }
+
+  switch (lval_type(v)) {
+    case LVAL_SYM:
+      chunk_emit(c, OP_LOOKUP, chunk_add_const(c, lval_copy(v)));
+      break;
+
+    case LVAL_SEXPR:
+      vm_compile_sexpr(c, v, depth);
+      break;
+
+    case LVAL_QEXPR:
+      // compile ahead of time in case it is later evaluated by 'if' or 'eval'
+      if (!v->code) { v->code = vm_compile(v); }
+      chunk_emit(c, OP_CONST, chunk_add_const(c, lval_copy(v)));
+      break;
+
+    /* all other lval types are pushed as they are */
+    default:
+      chunk_emit(c, OP_CONST, chunk_add_const(c, lval_copy(v)));
+      break;
+  }
+}
+
+chunk* vm_compile(lval* v) {
+  /* compile the cells of an S or Q-Expression as if it were an S-Expression */
+  chunk* c = chunk_new();
+  vm_compile_sexpr(c, v, 0);
+
+  // an empty expression still pushes its result
+  if (c->stack_size == 0) { c->stack_size = 1; }
+  chunk_trim(c);
+  return c;
+}
@@ -0,0 +1,110 @@
+/* most chunks need very little stack, so only allocate for larger ones */
+#define VM_STACK_SIZE 16
+
+lval* vm_run(lenv* e, chunk* c) {
+  lval* fixed[VM_STACK_SIZE];
+  lval** stack = fixed;
+  int capacity = VM_STACK_SIZE;
+  int sp = 0;
+
+  // every chunk ends in an instruction that pushes its result here
+  stack[0] = NULL;
+
+  /* environments entered by tail calls */
+  lframes frames = { 0, 0, NULL };
+
+  /* hold on to the chunk in case its owner is redefined while running */
+  chunk_retain(c);
+
+  for (int ip = 0; ip < c->count; ip += 2) {
+    if (ip == 0 && c->stack_size > capacity) {
+      capacity = c->stack_size;
+      stack = realloc(stack == fixed ? NULL : stack, sizeof(lval*) * capacity);
+    }
+
+    int operand = c->code[ip + 1];
+
+    switch (c->code[ip]) {
+      case OP_CONST:
+        stack[sp++] = lval_copy(c->consts[operand]);
+        break;
+
+      case OP_LOOKUP:
+        stack[sp++] = lenv_get(e, c->consts[operand]);
+        break;
+
+      case OP_JUMP:
+        ip += operand;
+        break;
+
+      case OP_FORM: {
+        lval* r;
+        int form = lval_eval_form(e, c->consts[operand], &r);
+        if (form == FORM_NONE) {
+          // not a special form after all, so run the call after the jump
+          ip += 2;
+          break;
+        }
+
+        /* a branch taken at the end of the chunk is run in place of c */
+        if (form == FORM_TAIL && ip + 4 + c->code[ip + 3] == c->count) {
+          chunk* next = r->code ? chunk_retain(r->code) : vm_compile(r);
+          lval_del(r);
+          chunk_release(c);
+          c = next;
+          ip = -2;
+          break;
+        }
+
+        stack[sp++] = form == FORM_TAIL ? lval_eval_qexpr(e, r) : r;
+        break;
+      }
+
+      case OP_EXPR: {
+        /* move the evaluated cells straight into a new S-Expression */
+        lval* v = lval_sexpr();
+        sp -= operand;
+        if (operand) {
+          lval_reserve(v, NULL, operand);
+          memcpy(v->cell, &stack[sp], sizeof(lval*) * operand);
+          v->count = operand;
+          v->buf->used = operand;
+        }
+
+        if (ip + 2 < c->count) {
+          stack[sp++] = lval_apply(e, v);
+          break;
+        }
+
+        /* the last instruction is in tail position, so run the callee in place of c */
+        if (!lval_eval_call(&e, &v, &frames)) {
+          stack[sp++] = v;
+          break;
+        }
+        chunk* next = v->code ? chunk_retain(v->code) : vm_compile(v);
+        lval_del(v);
+        chunk_release(c);
+        c = next;
+        ip = -2;
+        break;
+      }
+    }
+  }
+
+  chunk_release(c);
+  lframes_del(&frames);
+
+  lval* x = stack[0];
+  if (stack != fixed) { free(stack); }
+  return x;
+}
+
+lval* vm_eval(lenv* e, lval* v) {
+  /* run the cells of an S or Q-Expression, using code compiled ahead of time if there is any */
+  chunk* c = v->code ? chunk_retain(v->code) : vm_compile(v);
+  lval_del(v);
+
+  lval* x = vm_run(e, c);
+  chunk_release(c);
+  return x;
+}
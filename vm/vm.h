@@ -0,0 +1,12 @@
+/*
+Bytecode compiler and stack based virtual machine
+Selected with the --vm flag as an alternative to the tree-walking evaluator
+S-Expressions are compiled once into a flat list of instructions, and
+Q-Expressions that may later be evaluated carry their compiled code with them
+*/
+
+int vm_enabled = 0;
+
+#include "chunk.h"
+#include "compile.h"
+#include "run.h"